@@ -1,6 +1,10 @@
 #include <iostream>
 #include <stdexcept>
+#include <memory>
 #include <string>
+#include <vector>
+#include "../Common/Benchmark.h"
+#include "StaticBuilder.h"
 using namespace std;
 class Computer {
     public:
@@ -49,9 +53,56 @@ class CustomComputerBuilder : public ComputerBuilder {
         return computer;
     }
 };
+// Fields tracked by StaticComputerBuilder; all three are required
+namespace ComputerField {
+    constexpr uint32_t CPU = 1;
+    constexpr uint32_t RAM = 2;
+    constexpr uint32_t Storage = 4;
+    constexpr uint32_t required = CPU | RAM | Storage;
+}
+// Compile-time checked builder: build() does not compile until CPU, RAM and storage are set
+template <uint32_t Set = 0>
+class StaticComputerBuilder : public StaticBuilder<StaticComputerBuilder, Computer, ComputerField::required, Set> {
+    public:
+    StaticComputerBuilder() = default;
+    explicit StaticComputerBuilder(unique_ptr<Computer> partial) : StaticComputerBuilder::StaticBuilder(std::move(partial)) {}
+    auto setCPU(string cpuType) && {
+        this->product->cpu = std::move(cpuType);
+        return this->template with<ComputerField::CPU>();
+    }
+    auto setRAM(string ramType) && {
+        this->product->ram = std::move(ramType);
+        return this->template with<ComputerField::RAM>();
+    }
+    auto setStorage(string storageType) && {
+        this->product->storage = std::move(storageType);
+        return this->template with<ComputerField::Storage>();
+    }
+};
+static_assert(!CanBuild<decltype(StaticComputerBuilder<>().setCPU("AMD Ryzen 9"))>,
+              "A computer without RAM and storage must not build");
 int main() {
     CustomComputerBuilder builder;
     builder.setCPU("AMD Ryzen 9").setRAM("64gb DDR4").setStorage("2TB NVMe SSD");
     Computer* customComputer = builder.getComputer();
     customComputer->specifications();
+    delete customComputer;
+
+    auto staticComputer = StaticComputerBuilder<>().setCPU("AMD Ryzen 9").setRAM("64gb DDR4").setStorage("2TB NVMe SSD").build();
+    staticComputer->specifications();
+
+    // Inputs vary and results are kept so neither chain can be folded away
+    const size_t count = 1000000;
+    const string cpus[] = {"AMD Ryzen 9 7950X", "Intel Core i9-13900K", "Apple M2 Max"};
+    vector<Computer> built(1024);
+    double virtualNs = nanosecondsPerBuild(count, [&](size_t i) {
+        CustomComputerBuilder virtualBuilder;
+        Computer* computer = virtualBuilder.setCPU(cpus[i % 3]).setRAM("64gb DDR4").setStorage("2TB NVMe SSD").getComputer();
+        built[i % built.size()] = std::move(*computer);
+        delete computer;
+    });
+    double staticNs = nanosecondsPerBuild(count, [&](size_t i) {
+        built[i % built.size()] = std::move(*StaticComputerBuilder<>().setCPU(cpus[i % 3]).setRAM("64gb DDR4").setStorage("2TB NVMe SSD").build());
+    });
+    cout<<"Virtual builder: "<<virtualNs<<" ns per computer, static builder: "<<staticNs<<" ns"<<endl;
 }
\ No newline at end of file
@@ -2,6 +2,21 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "../Common/Benchmark.h"
+#include "StaticBuilder.h"
 
 // Product class
 class Product {
@@ -12,51 +27,317 @@ public:
     Product(const std::string& name, double price) : name(name), price(price) {}
 };
 
-// ShoppingCart class
-class ShoppingCart {
+// Interns product names so carts store a 4-byte id per line instead of a string
+class ProductNameTable {
+public:
+    static ProductNameTable& getInstance() {
+        static ProductNameTable instance;
+        return instance;
+    }
+
+    uint32_t intern(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(names.size());
+        names.push_back(name);
+        ids.emplace(names.back(), id);  // the deque keeps the viewed string in place
+        return id;
+    }
+
+    // Looks a name up without interning it; false if it was never interned
+    bool find(const std::string& name, uint32_t& id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it == ids.end()) {
+            return false;
+        }
+        id = it->second;
+        return true;
+    }
+
+    const std::string& name(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return names[id];
+    }
+
 private:
-    struct CartItem {
-        Product product;
-        int quantity;
+    ProductNameTable() = default;
+
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+// Open-addressing map from product id to cart line, in one flat array.
+// Linear probing with backward-shift deletion, so no tombstones build up
+// as lines are removed.
+class ProductLineIndex {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    void reserve(size_t count) {
+        if (count * 2 > slots.size()) {
+            rehash(count * 2);
+        }
+    }
+
+    uint32_t find(uint32_t productId) const {
+        if (slots.empty()) {
+            return npos;
+        }
+        for (size_t i = home(productId);; i = (i + 1) & mask()) {
+            if (slots[i].productId == productId) {
+                return slots[i].line;
+            }
+            if (slots[i].productId == npos) {
+                return npos;
+            }
+        }
+    }
+
+    // productId must not be present yet
+    void insert(uint32_t productId, uint32_t line) {
+        if ((count + 1) * 2 > slots.size()) {
+            rehash(std::max<size_t>(16, slots.size() * 2));
+        }
+        size_t i = home(productId);
+        while (slots[i].productId != npos) {
+            i = (i + 1) & mask();
+        }
+        slots[i] = Slot{productId, line};
+        ++count;
+    }
+
+    // productId must be present
+    void assign(uint32_t productId, uint32_t line) {
+        size_t i = home(productId);
+        while (slots[i].productId != productId) {
+            i = (i + 1) & mask();
+        }
+        slots[i].line = line;
+    }
+
+    // productId must be present
+    void erase(uint32_t productId) {
+        size_t hole = home(productId);
+        while (slots[hole].productId != productId) {
+            hole = (hole + 1) & mask();
+        }
+        // Shift later entries of the probe run back into the hole, unless
+        // that would move them in front of their home slot
+        for (size_t i = (hole + 1) & mask(); slots[i].productId != npos; i = (i + 1) & mask()) {
+            size_t wanted = home(slots[i].productId);
+            if (((i - wanted) & mask()) >= ((i - hole) & mask())) {
+                slots[hole] = slots[i];
+                hole = i;
+            }
+        }
+        slots[hole] = Slot{};
+        --count;
+    }
 
-        CartItem(const Product& product, int quantity)
-            : product(product), quantity(quantity) {}
+private:
+    struct Slot {
+        uint32_t productId = npos;
+        uint32_t line = 0;
     };
 
-    std::vector<CartItem> items;
+    size_t mask() const {
+        return slots.size() - 1;
+    }
+
+    // Fibonacci hashing: the top bits of the product spread sequential ids
+    size_t home(uint32_t productId) const {
+        return static_cast<uint32_t>(productId * 2654435769u) >> shift;
+    }
+
+    void rehash(size_t minimumSlots) {
+        size_t capacity = 16;
+        unsigned bits = 4;
+        while (capacity < minimumSlots) {
+            capacity *= 2;
+            ++bits;
+        }
+        std::vector<Slot> old = std::move(slots);
+        slots.assign(capacity, Slot{});
+        shift = 32 - bits;
+        count = 0;
+        for (const Slot& slot : old) {
+            if (slot.productId != npos) {
+                insert(slot.productId, slot.line);
+            }
+        }
+    }
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+    unsigned shift = 28;
+};
+
+// ShoppingCart class
+// Line items are stored column-wise: the total only reads the price and
+// quantity arrays, which are contiguous and vectorizable. Each product has
+// exactly one line, found through lineIndex.
+class ShoppingCart {
+private:
+    std::vector<double> prices;
+    std::vector<int> quantities;
+    std::vector<uint32_t> nameIds;
+    ProductLineIndex lineIndex;
     double discountPercent;
+    double promotionDiscount = 0;
     std::string deliveryPreference;
 
+    // Cached result of computeTotal(); any change to the cart clears it
+    mutable double cachedTotal = 0;
+    mutable bool totalValid = false;
+
+    // Four independent accumulators break the serial dependency on one sum,
+    // so the compiler can keep them in vector lanes without -ffast-math
+    static double sumLineTotals(const double* price, const int* quantity, size_t count) {
+        double lane[4] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            lane[0] += price[i] * quantity[i];
+            lane[1] += price[i + 1] * quantity[i + 1];
+            lane[2] += price[i + 2] * quantity[i + 2];
+            lane[3] += price[i + 3] * quantity[i + 3];
+        }
+        for (; i < count; ++i) {
+            lane[0] += price[i] * quantity[i];
+        }
+        return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+    }
+
 public:
     ShoppingCart() : discountPercent(0.0), deliveryPreference("Standard") {}
 
+    void reserve(size_t lineCount) {
+        prices.reserve(lineCount);
+        quantities.reserve(lineCount);
+        nameIds.reserve(lineCount);
+        lineIndex.reserve(lineCount);
+    }
+
+    // Adding a product that is already in the cart increases its quantity;
+    // the line keeps its original price
     void addProduct(const Product& product, int quantity) {
-        items.push_back(CartItem(product, quantity));
+        uint32_t productId = ProductNameTable::getInstance().intern(product.name);
+        uint32_t line = lineIndex.find(productId);
+        if (line != ProductLineIndex::npos) {
+            quantities[line] += quantity;
+        } else {
+            lineIndex.insert(productId, static_cast<uint32_t>(prices.size()));
+            prices.push_back(product.price);
+            quantities.push_back(quantity);
+            nameIds.push_back(productId);
+        }
+        totalValid = false;
+    }
+
+    // Sets the quantity of a product in the cart; zero or less removes it.
+    // Returns false if the product is not in the cart.
+    bool updateQuantity(uint32_t productId, int quantity) {
+        if (quantity <= 0) {
+            return removeProduct(productId);
+        }
+        uint32_t line = lineIndex.find(productId);
+        if (line == ProductLineIndex::npos) {
+            return false;
+        }
+        quantities[line] = quantity;
+        totalValid = false;
+        return true;
+    }
+
+    // Moves the last line into the removed one, so line order is not kept.
+    // Returns false if the product is not in the cart.
+    bool removeProduct(uint32_t productId) {
+        uint32_t line = lineIndex.find(productId);
+        if (line == ProductLineIndex::npos) {
+            return false;
+        }
+        lineIndex.erase(productId);
+        size_t last = prices.size() - 1;
+        if (line != last) {
+            prices[line] = prices[last];
+            quantities[line] = quantities[last];
+            nameIds[line] = nameIds[last];
+            lineIndex.assign(nameIds[line], line);
+        }
+        prices.pop_back();
+        quantities.pop_back();
+        nameIds.pop_back();
+        totalValid = false;
+        return true;
     }
 
     void applyDiscount(double discount) {
         discountPercent = discount;
+        totalValid = false;
+    }
+
+    // Amount taken off the subtotal by promotions, before the percentage discount
+    void setPromotionDiscount(double amount) {
+        promotionDiscount = amount;
+        totalValid = false;
     }
 
     void setDeliveryPreference(const std::string& preference) {
         deliveryPreference = preference;
     }
 
-    double calculateTotal() const {
-        double total = 0;
-        for (const auto& item : items) {
-            total += item.product.price * item.quantity;
-        }
+    size_t itemCount() const {
+        return prices.size();
+    }
+
+    uint32_t productIdAt(size_t line) const {
+        return nameIds[line];
+    }
+
+    int quantityOf(uint32_t productId) const {
+        uint32_t line = lineIndex.find(productId);
+        return line == ProductLineIndex::npos ? 0 : quantities[line];
+    }
+
+    double priceOf(uint32_t productId) const {
+        uint32_t line = lineIndex.find(productId);
+        return line == ProductLineIndex::npos ? 0 : prices[line];
+    }
+
+    double subtotal() const {
+        return sumLineTotals(prices.data(), quantities.data(), prices.size());
+    }
+
+    // Computes the total without touching the cache, so it is safe to call
+    // from several threads at once
+    double computeTotal() const {
+        double total = std::max(0.0, subtotal() - promotionDiscount);
         double discountAmount = total * (discountPercent / 100);
         return total - discountAmount;
     }
 
+    double calculateTotal() const {
+        if (!totalValid) {
+            cachedTotal = computeTotal();
+            totalValid = true;
+        }
+        return cachedTotal;
+    }
+
     void checkout() const {
+        ProductNameTable& names = ProductNameTable::getInstance();
         std::cout << "Finalizing order with the following items:" << std::endl;
-        for (const auto& item : items) {
-            std::cout << "Product: " << item.product.name
-                      << ", Price: $" << item.product.price
-                      << ", Quantity: " << item.quantity << std::endl;
+        for (size_t i = 0; i < prices.size(); ++i) {
+            std::cout << "Product: " << names.name(nameIds[i])
+                      << ", Price: $" << prices[i]
+                      << ", Quantity: " << quantities[i] << std::endl;
+        }
+        if (promotionDiscount > 0) {
+            std::cout << "Promotions: -$" << promotionDiscount << std::endl;
         }
         std::cout << "Total after discount: $" << calculateTotal() << std::endl;
         std::cout << "Discount: " << discountPercent << "%" << std::endl;
@@ -65,11 +346,293 @@ public:
     }
 };
 
+// A promotion rule. Products are referred to by their interned name id.
+struct PromotionRule {
+    enum Kind {
+        PercentOff,   // percent off every unit of one product
+        BuyXGetY,     // for every buy + free units of one product, free units cost nothing
+        Bundle,       // fixed amount off per complete set of the products
+        TieredSpend   // percent off the whole cart, by the highest spend tier reached
+    };
+
+    struct Tier {
+        double minimumSpend;
+        double percent;
+    };
+
+    Kind kind = PercentOff;
+    std::vector<uint32_t> products;
+    double percent = 0;
+    int buyQuantity = 0;
+    int freeQuantity = 0;
+    double amountOff = 0;
+    std::vector<Tier> tiers;
+
+    // Throws if percent is outside 0..100
+    static PromotionRule percentOff(const std::string& product, double percent) {
+        requirePercent(percent);
+        PromotionRule rule;
+        rule.kind = PercentOff;
+        rule.products.push_back(ProductNameTable::getInstance().intern(product));
+        rule.percent = percent;
+        return rule;
+    }
+
+    // Throws unless at least one unit is bought and free is not negative
+    static PromotionRule buyXGetY(const std::string& product, int buy, int free) {
+        if (buy < 1 || free < 0) {
+            throw std::invalid_argument("Buy X get Y needs buy >= 1 and free >= 0");
+        }
+        PromotionRule rule;
+        rule.kind = BuyXGetY;
+        rule.products.push_back(ProductNameTable::getInstance().intern(product));
+        rule.buyQuantity = buy;
+        rule.freeQuantity = free;
+        return rule;
+    }
+
+    // Throws if the bundle is empty or the amount off is negative
+    static PromotionRule bundle(const std::vector<std::string>& products, double amountOff) {
+        if (products.empty()) {
+            throw std::invalid_argument("A bundle needs at least one product");
+        }
+        if (amountOff < 0) {
+            throw std::invalid_argument("A bundle cannot add to the price");
+        }
+        PromotionRule rule;
+        rule.kind = Bundle;
+        for (const auto& product : products) {
+            rule.products.push_back(ProductNameTable::getInstance().intern(product));
+        }
+        rule.amountOff = amountOff;
+        return rule;
+    }
+
+    // Throws unless there is at least one tier, minimum spends are
+    // non-negative and strictly ascending, and percents are within 0..100
+    static PromotionRule tieredSpend(std::vector<Tier> tiers) {
+        if (tiers.empty()) {
+            throw std::invalid_argument("Tiered spend needs at least one tier");
+        }
+        for (size_t i = 0; i < tiers.size(); ++i) {
+            requirePercent(tiers[i].percent);
+            if (!(tiers[i].minimumSpend >= 0)) {
+                throw std::invalid_argument("Tier minimum spend must not be negative");
+            }
+            if (i > 0 && !(tiers[i - 1].minimumSpend < tiers[i].minimumSpend)) {
+                throw std::invalid_argument("Tiers must be in ascending order of minimum spend");
+            }
+        }
+        PromotionRule rule;
+        rule.kind = TieredSpend;
+        rule.tiers = std::move(tiers);
+        return rule;
+    }
+
+private:
+    static void requirePercent(double percent) {
+        if (!(percent >= 0 && percent <= 100)) {
+            throw std::invalid_argument("Percent off must be between 0 and 100");
+        }
+    }
+};
+
+// Promotions currently applied to one cart, kept so that a change to one
+// line only re-evaluates the rules that mention its product
+struct PromotionState {
+    std::vector<std::pair<uint32_t, double>> itemDiscounts;  // rule index -> amount
+    double itemTotal = 0;
+    double spendDiscount = 0;
+
+    double discount() const {
+        return itemTotal + spendDiscount;
+    }
+};
+
+// Evaluates promotion rules against carts. The rules are compiled into a
+// product -> rules index, so a cart only evaluates the rules for products it
+// contains; spend tiers, which depend on the whole cart, are kept apart.
+// Item discounts add up; of the spend tiers, the best one applies, to the
+// subtotal left after item discounts.
+class PromotionEngine {
+public:
+    explicit PromotionEngine(std::vector<PromotionRule> promotionRules) : rules(std::move(promotionRules)) {
+        uint32_t productCount = 0;
+        for (const auto& rule : rules) {
+            for (uint32_t product : rule.products) {
+                productCount = std::max(productCount, product + 1);
+            }
+        }
+        // Counting sort into a flat array: rulesFor(p) is indexRules[indexOffsets[p] .. indexOffsets[p + 1])
+        indexOffsets.assign(productCount + 1, 0);
+        for (const auto& rule : rules) {
+            for (uint32_t product : rule.products) {
+                ++indexOffsets[product + 1];
+            }
+        }
+        for (uint32_t p = 0; p < productCount; ++p) {
+            indexOffsets[p + 1] += indexOffsets[p];
+        }
+        indexRules.resize(indexOffsets[productCount]);
+        std::vector<uint32_t> fill(indexOffsets.begin(), indexOffsets.end() - 1);
+        for (uint32_t r = 0; r < rules.size(); ++r) {
+            if (rules[r].kind == PromotionRule::TieredSpend) {
+                spendRules.push_back(r);
+            }
+            for (uint32_t product : rules[r].products) {
+                indexRules[fill[product]++] = r;
+            }
+        }
+    }
+
+    size_t ruleCount() const {
+        return rules.size();
+    }
+
+    // Evaluates every candidate rule for the cart from scratch
+    double evaluate(const ShoppingCart& cart, PromotionState& state) const {
+        state.itemDiscounts.clear();
+        state.itemTotal = 0;
+        for (size_t line = 0; line < cart.itemCount(); ++line) {
+            forEachRuleOf(cart.productIdAt(line), [&](uint32_t r) {
+                if (findDiscount(state, r) == state.itemDiscounts.end()) {
+                    setDiscount(state, r, ruleDiscount(rules[r], cart));
+                }
+            });
+        }
+        state.spendDiscount = bestSpendDiscount(cart, state);
+        return state.discount();
+    }
+
+    // Brings state up to date after the quantity of one product changed
+    double reevaluate(const ShoppingCart& cart, PromotionState& state, uint32_t changedProduct) const {
+        forEachRuleOf(changedProduct, [&](uint32_t r) {
+            setDiscount(state, r, ruleDiscount(rules[r], cart));
+        });
+        state.spendDiscount = bestSpendDiscount(cart, state);
+        return state.discount();
+    }
+
+    // Discount of one rule for the cart, without the index; used to check
+    // and benchmark the indexed evaluation
+    double ruleDiscount(size_t ruleIndex, const ShoppingCart& cart) const {
+        return ruleDiscount(rules[ruleIndex], cart);
+    }
+
+    bool isSpendRule(size_t ruleIndex) const {
+        return rules[ruleIndex].kind == PromotionRule::TieredSpend;
+    }
+
+private:
+    template <typename Visit>
+    void forEachRuleOf(uint32_t product, Visit visit) const {
+        if (product + 1 >= indexOffsets.size()) {
+            return;  // no rule mentions this product
+        }
+        for (uint32_t i = indexOffsets[product]; i < indexOffsets[product + 1]; ++i) {
+            visit(indexRules[i]);
+        }
+    }
+
+    static std::vector<std::pair<uint32_t, double>>::iterator findDiscount(PromotionState& state, uint32_t rule) {
+        return std::find_if(state.itemDiscounts.begin(), state.itemDiscounts.end(),
+                            [rule](const auto& entry) { return entry.first == rule; });
+    }
+
+    // Records a rule's discount; only rules that currently apply are stored
+    static void setDiscount(PromotionState& state, uint32_t rule, double amount) {
+        auto it = findDiscount(state, rule);
+        if (it != state.itemDiscounts.end()) {
+            state.itemTotal -= it->second;
+            if (amount > 0) {
+                it->second = amount;
+            } else {
+                *it = state.itemDiscounts.back();
+                state.itemDiscounts.pop_back();
+            }
+        } else if (amount > 0) {
+            state.itemDiscounts.emplace_back(rule, amount);
+        }
+        if (amount > 0) {
+            state.itemTotal += amount;
+        }
+    }
+
+    static double ruleDiscount(const PromotionRule& rule, const ShoppingCart& cart) {
+        switch (rule.kind) {
+            case PromotionRule::PercentOff: {
+                uint32_t product = rule.products.front();
+                return cart.priceOf(product) * cart.quantityOf(product) * rule.percent / 100;
+            }
+            case PromotionRule::BuyXGetY: {
+                uint32_t product = rule.products.front();
+                int groups = cart.quantityOf(product) / (rule.buyQuantity + rule.freeQuantity);
+                return groups * rule.freeQuantity * cart.priceOf(product);
+            }
+            case PromotionRule::Bundle: {
+                int sets = INT_MAX;
+                for (uint32_t product : rule.products) {
+                    sets = std::min(sets, cart.quantityOf(product));
+                }
+                return sets * rule.amountOff;
+            }
+            case PromotionRule::TieredSpend:
+                break;
+        }
+        return 0;
+    }
+
+    double bestSpendDiscount(const ShoppingCart& cart, const PromotionState& state) const {
+        double spend = std::max(0.0, cart.subtotal() - state.itemTotal);
+        double best = 0;
+        for (uint32_t r : spendRules) {
+            const auto& tiers = rules[r].tiers;
+            auto reached = std::upper_bound(tiers.begin(), tiers.end(), spend,
+                [](double amount, const PromotionRule::Tier& tier) { return amount < tier.minimumSpend; });
+            if (reached != tiers.begin()) {
+                best = std::max(best, spend * std::prev(reached)->percent / 100);
+            }
+        }
+        return best;
+    }
+
+    std::vector<PromotionRule> rules;
+    std::vector<uint32_t> indexOffsets;
+    std::vector<uint32_t> indexRules;
+    std::vector<uint32_t> spendRules;
+};
+
+// Prices a batch of carts, e.g. for a pricing re-run, splitting it into one
+// contiguous range per thread. totals[i] receives the total of carts[i].
+void priceCarts(const std::vector<std::unique_ptr<ShoppingCart>>& carts, std::vector<double>& totals,
+                unsigned threadCount) {
+    totals.resize(carts.size());
+    threadCount = std::max(1u, std::min<unsigned>(threadCount, static_cast<unsigned>(carts.size())));
+    size_t perThread = (carts.size() + threadCount - 1) / threadCount;
+    auto priceRange = [&carts, &totals](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            totals[i] = carts[i]->computeTotal();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threadCount; ++t) {
+        size_t begin = std::min(carts.size(), t * perThread);
+        workers.emplace_back(priceRange, begin, std::min(carts.size(), begin + perThread));
+    }
+    priceRange(0, std::min(carts.size(), perThread));
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
 // CartBuilder interface
 class CartBuilder {
 public:
     virtual ~CartBuilder() {}
+    virtual CartBuilder& reserve(size_t lineCount) = 0;
     virtual CartBuilder& addProduct(const Product& product, int quantity) = 0;
+    virtual CartBuilder& updateQuantity(const Product& product, int quantity) = 0;
+    virtual CartBuilder& removeProduct(const Product& product) = 0;
     virtual CartBuilder& applyDiscount(double discount) = 0;
     virtual CartBuilder& setDeliveryPreference(const std::string& preference) = 0;
     virtual std::unique_ptr<ShoppingCart> getCart() = 0;
@@ -83,11 +646,34 @@ private:
 public:
     ConcreteCartBuilder() { cart = std::make_unique<ShoppingCart>(); }
     
+    // Hint for large carts, so adding lineCount products never reallocates
+    CartBuilder& reserve(size_t lineCount) override {
+        cart->reserve(lineCount);
+        return *this;
+    }
+
     CartBuilder& addProduct(const Product& product, int quantity) override {
         cart->addProduct(product, quantity);
         return *this;
     }
 
+    // Products that are not in the cart are ignored
+    CartBuilder& updateQuantity(const Product& product, int quantity) override {
+        uint32_t productId;
+        if (ProductNameTable::getInstance().find(product.name, productId)) {
+            cart->updateQuantity(productId, quantity);
+        }
+        return *this;
+    }
+
+    CartBuilder& removeProduct(const Product& product) override {
+        uint32_t productId;
+        if (ProductNameTable::getInstance().find(product.name, productId)) {
+            cart->removeProduct(productId);
+        }
+        return *this;
+    }
+
     CartBuilder& applyDiscount(double discount) override {
         cart->applyDiscount(discount);
         return *this;
@@ -103,16 +689,258 @@ public:
     }
 };
 
+// Fields tracked by StaticCartBuilder; a cart needs at least one product
+namespace CartField {
+    constexpr uint32_t Products = 1;
+}
+
+// Compile-time checked cart builder: build() does not compile until a product
+// has been added. Options that are not tracked return the same builder type.
+template <uint32_t Set = 0>
+class StaticCartBuilder : public StaticBuilder<StaticCartBuilder, ShoppingCart, CartField::Products, Set> {
+public:
+    StaticCartBuilder() = default;
+    explicit StaticCartBuilder(std::unique_ptr<ShoppingCart> partial) : StaticCartBuilder::StaticBuilder(std::move(partial)) {}
+
+    auto reserve(size_t lineCount) && {
+        this->product->reserve(lineCount);
+        return this->template with<0>();
+    }
+
+    auto addProduct(const Product& product, int quantity) && {
+        this->product->addProduct(product, quantity);
+        return this->template with<CartField::Products>();
+    }
+
+    auto applyDiscount(double discount) && {
+        this->product->applyDiscount(discount);
+        return this->template with<0>();
+    }
+
+    auto setDeliveryPreference(const std::string& preference) && {
+        this->product->setDeliveryPreference(preference);
+        return this->template with<0>();
+    }
+};
+
+static_assert(!CanBuild<StaticCartBuilder<>>, "An empty cart must not build");
+
 // Main function demonstrating usage of the builder
 int main() {
     ConcreteCartBuilder builder;
     builder.addProduct(Product("Laptop", 999.99), 1)
-           .addProduct(Product("USB Cable", 19.99), 2)
+           .addProduct(Product("USB Cable", 19.99), 1)
+           .addProduct(Product("Mouse", 24.5), 1)
+           .addProduct(Product("USB Cable", 19.99), 1)  // merged into the first line
+           .removeProduct(Product("Mouse", 24.5))
            .applyDiscount(10)
            .setDeliveryPreference("Express");
 
     auto cart = builder.getCart();
     cart->checkout();
 
+    // The same cart through the compile-time checked builder, against the virtual one
+    const Product laptop("Laptop", 999.99);
+    const Product cable("USB Cable", 19.99);
+    const size_t buildCount = 1000000;
+    double sink = 0;  // keeps the builds from being optimized away
+    double virtualNs = nanosecondsPerBuild(buildCount, [&](size_t i) {
+        ConcreteCartBuilder virtualBuilder;
+        virtualBuilder.addProduct(laptop, 1).addProduct(cable, 1 + static_cast<int>(i % 3)).applyDiscount(10);
+        sink += virtualBuilder.getCart()->calculateTotal();
+    });
+    double staticNs = nanosecondsPerBuild(buildCount, [&](size_t i) {
+        sink += StaticCartBuilder<>()
+                    .addProduct(laptop, 1)
+                    .addProduct(cable, 1 + static_cast<int>(i % 3))
+                    .applyDiscount(10)
+                    .build()
+                    ->calculateTotal();
+    });
+    // Both builders must produce the same cart, to the cent
+    bool totalsMatch = true;
+    for (int cables = 1; cables <= 3; ++cables) {
+        ConcreteCartBuilder virtualBuilder;
+        virtualBuilder.addProduct(laptop, 1).addProduct(cable, cables).applyDiscount(10);
+        double staticTotal = StaticCartBuilder<>().addProduct(laptop, 1).addProduct(cable, cables).applyDiscount(10)
+                                 .build()->calculateTotal();
+        totalsMatch = totalsMatch && virtualBuilder.getCart()->calculateTotal() == staticTotal;
+    }
+    std::cout << "Virtual cart builder: " << virtualNs << " ns per cart, static builder: " << staticNs
+              << " ns (totals " << (totalsMatch ? "match" : "MISMATCH") << ", sum $"
+              << static_cast<long long>(sink) << ")" << std::endl;
+
+    // Re-price a large batch of carts on increasing thread counts
+    const size_t cartCount = 1000000;
+    const Product catalog[] = {Product("Laptop", 999.99), Product("USB Cable", 19.99), Product("Mouse", 24.5),
+                               Product("Monitor", 189.0), Product("Keyboard", 49.95), Product("Headset", 79.0)};
+    std::vector<std::unique_ptr<ShoppingCart>> carts;
+    carts.reserve(cartCount);
+    for (size_t i = 0; i < cartCount; ++i) {
+        ConcreteCartBuilder cartBuilder;
+        for (size_t line = 0; line < 2 + i % 7; ++line) {
+            cartBuilder.addProduct(catalog[(i + line) % 6], 1 + static_cast<int>(line % 3));
+        }
+        cartBuilder.applyDiscount(static_cast<double>(i % 4) * 5);
+        carts.push_back(cartBuilder.getCart());
+    }
+    std::vector<double> totals;
+    std::vector<unsigned> threadCounts = {1, 2, 4};
+    if (std::thread::hardware_concurrency() > 4) {
+        threadCounts.push_back(std::thread::hardware_concurrency());
+    }
+    for (unsigned threads : threadCounts) {
+        auto start = std::chrono::steady_clock::now();
+        priceCarts(carts, totals, threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double sum = 0;
+        for (double total : totals) {
+            sum += total;
+        }
+        std::cout << "Priced " << cartCount << " carts on " << threads << " thread(s) in "
+                  << seconds * 1000 << " ms (sum $" << static_cast<long long>(sum) << ")" << std::endl;
+    }
+    carts.clear();
+
+    // A B2B order with thousands of lines, built with and without a reserve hint
+    const size_t lineCount = 20000;
+    std::vector<Product> skus;
+    for (size_t i = 0; i < lineCount; ++i) {
+        skus.emplace_back("PART-" + std::to_string(i), 0.5 + static_cast<double>(i % 400));
+    }
+    for (size_t hint : {size_t(0), lineCount}) {
+        auto start = std::chrono::steady_clock::now();
+        ConcreteCartBuilder b2bBuilder;
+        b2bBuilder.reserve(hint);
+        for (int pass = 0; pass < 2; ++pass) {  // the second pass merges into existing lines
+            for (const auto& sku : skus) {
+                b2bBuilder.addProduct(sku, 10);
+            }
+        }
+        for (size_t i = 0; i < lineCount; i += 2) {
+            b2bBuilder.updateQuantity(skus[i], 5);
+        }
+        for (size_t i = 1; i < lineCount; i += 4) {
+            b2bBuilder.removeProduct(skus[i]);
+        }
+        auto b2bCart = b2bBuilder.getCart();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "B2B cart, reserve hint " << hint << ": " << b2bCart->itemCount() << " lines, "
+                  << b2bCart->quantityOf(b2bCart->productIdAt(0)) << " of the first, total $"
+                  << static_cast<long long>(b2bCart->calculateTotal()) << ", built in " << seconds * 1000
+                  << " ms" << std::endl;
+    }
+
+    // Promotions on a small cart
+    PromotionEngine promotions({
+        PromotionRule::percentOff("Monitor", 15),
+        PromotionRule::buyXGetY("USB Cable", 2, 1),
+        PromotionRule::bundle({"Keyboard", "Mouse"}, 10),
+        PromotionRule::tieredSpend({{100, 5}, {500, 10}}),
+    });
+    auto promoCart = ConcreteCartBuilder()
+                         .addProduct(Product("Monitor", 189.0), 1)
+                         .addProduct(Product("USB Cable", 19.99), 3)
+                         .addProduct(Product("Keyboard", 49.95), 1)
+                         .addProduct(Product("Mouse", 24.5), 1)
+                         .getCart();
+    PromotionState promoState;
+    promoCart->setPromotionDiscount(promotions.evaluate(*promoCart, promoState));
+    promoCart->checkout();
+    try {
+        PromotionRule::buyXGetY("USB Cable", 0, 1);
+    } catch (const std::invalid_argument& error) {
+        std::cout << "Rejected promotion: " << error.what() << std::endl;
+    }
+    try {
+        PromotionRule::tieredSpend({{500, 10}, {100, 5}});
+    } catch (const std::invalid_argument& error) {
+        std::cout << "Rejected promotion: " << error.what() << std::endl;
+    }
+
+    // 10k rules over 5k products, evaluated for 1M carts
+    const size_t productCount = 5000;
+    const size_t ruleCount = 10000;
+    std::mt19937 random(42);
+    std::vector<Product> products;
+    for (size_t i = 0; i < productCount; ++i) {
+        products.emplace_back("SKU-" + std::to_string(i), 1 + static_cast<double>(random() % 50000) / 100);
+    }
+    auto anyProduct = [&]() -> const Product& { return products[random() % productCount]; };
+    std::vector<PromotionRule> rules;
+    for (int i = 0; i < 4; ++i) {
+        rules.push_back(PromotionRule::tieredSpend({{200.0 + i * 100, 2.0 + i}, {1000.0 + i * 500, 5.0 + i}}));
+    }
+    while (rules.size() < ruleCount) {
+        switch (random() % 10) {
+            case 0: case 1: case 2: case 3: case 4:
+                rules.push_back(PromotionRule::percentOff(anyProduct().name, 5 + random() % 30));
+                break;
+            case 5: case 6: case 7:
+                rules.push_back(PromotionRule::buyXGetY(anyProduct().name, 2 + random() % 2, 1));
+                break;
+            default:
+                rules.push_back(PromotionRule::bundle({anyProduct().name, anyProduct().name}, 5 + random() % 20));
+                break;
+        }
+    }
+    PromotionEngine engine(std::move(rules));
+
+    for (size_t i = 0; i < cartCount; ++i) {
+        ConcreteCartBuilder cartBuilder;
+        for (size_t line = 0; line < 3 + random() % 6; ++line) {
+            cartBuilder.addProduct(anyProduct(), 1 + static_cast<int>(random() % 4));
+        }
+        carts.push_back(cartBuilder.getCart());
+    }
+    std::vector<PromotionState> states(cartCount);
+
+    auto start = std::chrono::steady_clock::now();
+    double discounted = 0;
+    for (size_t i = 0; i < cartCount; ++i) {
+        double discount = engine.evaluate(*carts[i], states[i]);
+        carts[i]->setPromotionDiscount(discount);
+        discounted += discount;
+    }
+    double indexedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Scanning all rules per cart, on a sample; the item discounts must match
+    const size_t sampleCount = 1000;
+    start = std::chrono::steady_clock::now();
+    size_t mismatches = 0;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        double itemTotal = 0;
+        for (size_t r = 0; r < engine.ruleCount(); ++r) {
+            if (!engine.isSpendRule(r)) {
+                itemTotal += engine.ruleDiscount(r, *carts[i]);
+            }
+        }
+        mismatches += std::abs(itemTotal - states[i].itemTotal) > 1e-6;
+    }
+    double scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                         * (cartCount / sampleCount);
+
+    // One line item changes in every cart: re-evaluate incrementally
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < cartCount; ++i) {
+        const Product& added = anyProduct();
+        carts[i]->addProduct(added, 1);
+        uint32_t productId = ProductNameTable::getInstance().intern(added.name);
+        carts[i]->setPromotionDiscount(engine.reevaluate(*carts[i], states[i], productId));
+    }
+    double incrementalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (size_t i = 0; i < sampleCount; ++i) {
+        PromotionState fresh;
+        mismatches += std::abs(engine.evaluate(*carts[i], fresh) - states[i].discount()) > 1e-6;
+    }
+
+    std::cout << "Promotions: " << ruleCount << " rules x " << cartCount << " carts, $"
+              << static_cast<long long>(discounted) << " discounted" << std::endl;
+    std::cout << "  indexed evaluation:     " << indexedSeconds * 1000 << " ms" << std::endl;
+    std::cout << "  scanning every rule:    " << scanSeconds * 1000 << " ms (extrapolated from "
+              << sampleCount << " carts)" << std::endl;
+    std::cout << "  incremental, one line:  " << incrementalSeconds * 1000 << " ms" << std::endl;
+    std::cout << "  mismatches: " << mismatches << std::endl;
+
     return 0;
 }
@@ -2,50 +2,69 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <variant>
 
-// Abstract base class for post components
-class PostComponent {
-public:
-    virtual void display() const = 0;
-    virtual ~PostComponent() {}
-};
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "../Common/AllocationCounter.h"
+#include "../Common/Benchmark.h"
+#include "StaticBuilder.h"
+
+// Post components are plain value types, stored inline in the post
+// (see PostComponent below) instead of one heap object each
 
 // Image component
-class Image : public PostComponent {
+class Image {
 public:
     std::string url;
-    Image(const std::string& url) : url(url) {}
-    void display() const override {
+    explicit Image(std::string url) : url(std::move(url)) {}
+    void display() const {
         std::cout << "Image URL: " << url << std::endl;
     }
 };
 
 // Caption component
-class Caption : public PostComponent {
+class Caption {
 public:
     std::string text;
-    Caption(const std::string& text) : text(text) {}
-    void display() const override {
+    explicit Caption(std::string text) : text(std::move(text)) {}
+    void display() const {
         std::cout << "Caption: " << text << std::endl;
     }
 };
 
 // Location component
-class Location : public PostComponent {
+class Location {
 public:
     std::string place;
-    Location(const std::string& place) : place(place) {}
-    void display() const override {
+    explicit Location(std::string place) : place(std::move(place)) {}
+    void display() const {
         std::cout << "Location: " << place << std::endl;
     }
 };
 
 // Tags component
-class Tags : public PostComponent {
+class Tags {
 public:
     std::vector<std::string> tags;
-    Tags(const std::vector<std::string>& tags) : tags(tags) {}
-    void display() const override {
+    explicit Tags(std::vector<std::string> tags) : tags(std::move(tags)) {}
+    void display() const {
         std::cout << "Tags: ";
         for (const auto& tag : tags) {
             std::cout << "#" << tag << " ";
@@ -55,82 +74,592 @@ public:
 };
 
 // Visibility setting component
-class Visibility : public PostComponent {
+class Visibility {
 public:
     std::string visibility;
-    Visibility(const std::string& visibility) : visibility(visibility) {}
-    void display() const override {
+    explicit Visibility(std::string visibility) : visibility(std::move(visibility)) {}
+    void display() const {
         std::cout << "Visibility: " << visibility << std::endl;
     }
 };
 
+// Any post component
+using PostComponent = std::variant<Image, Caption, Location, Tags, Visibility>;
+
 // Composite class for an Instagram post
 class InstagramPost {
 private:
-    std::vector<std::unique_ptr<PostComponent>> components;
+    std::vector<PostComponent> components;
 
 public:
-    void addComponent(std::unique_ptr<PostComponent> component) {
+    void reserveComponents(size_t count) {
+        components.reserve(count);
+    }
+
+    void addComponent(PostComponent component) {
         components.push_back(std::move(component));
     }
 
+    // Constructs the component directly in the post's storage
+    template <typename Component, typename... Args>
+    void emplaceComponent(Args&&... args) {
+        components.emplace_back(std::in_place_type<Component>, std::forward<Args>(args)...);
+    }
+
+    const std::vector<PostComponent>& getComponents() const {
+        return components;
+    }
+
     void display() const {
         for (const auto& component : components) {
-            component->display();
+            std::visit([](const auto& value) { value.display(); }, component);
+        }
+    }
+};
+
+enum class FeedFormat {
+    Binary,
+    Json
+};
+
+// Appends posts to a buffer in one pass. Components are written straight
+// from their strings; the variant is dispatched with std::visit, not a
+// virtual call.
+//
+// Binary: per post a varint component count, then per component its
+// variant index as one byte followed by a varint-length string, or for Tags
+// a varint count of such strings.
+// JSON: one object per post with a key per component, in insertion order.
+class FeedWriter {
+public:
+    FeedWriter(FeedFormat format, std::string& out) : format(format), out(out) {}
+
+    void writePost(const InstagramPost& post) {
+        const auto& components = post.getComponents();
+        if (format == FeedFormat::Binary) {
+            appendVarint(components.size());
+            for (const auto& component : components) {
+                out.push_back(static_cast<char>(component.index()));
+                std::visit([this](const auto& value) { writeBinary(value); }, component);
+            }
+            return;
+        }
+        out.push_back('{');
+        for (size_t i = 0; i < components.size(); ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            std::visit([this](const auto& value) { writeJson(value); }, components[i]);
+        }
+        out.push_back('}');
+    }
+
+    void appendVarint(uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+private:
+    void writeBinary(const Image& image) { appendBinaryString(image.url); }
+    void writeBinary(const Caption& caption) { appendBinaryString(caption.text); }
+    void writeBinary(const Location& location) { appendBinaryString(location.place); }
+    void writeBinary(const Visibility& visibility) { appendBinaryString(visibility.visibility); }
+
+    void writeBinary(const Tags& tags) {
+        appendVarint(tags.tags.size());
+        for (const auto& tag : tags.tags) {
+            appendBinaryString(tag);
+        }
+    }
+
+    void writeJson(const Image& image) { appendJsonField("image", image.url); }
+    void writeJson(const Caption& caption) { appendJsonField("caption", caption.text); }
+    void writeJson(const Location& location) { appendJsonField("location", location.place); }
+    void writeJson(const Visibility& visibility) { appendJsonField("visibility", visibility.visibility); }
+
+    void writeJson(const Tags& tags) {
+        out.append("\"tags\":[");
+        for (size_t i = 0; i < tags.tags.size(); ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            appendJsonString(tags.tags[i]);
+        }
+        out.push_back(']');
+    }
+
+    void appendBinaryString(std::string_view text) {
+        appendVarint(text.size());
+        out.append(text);
+    }
+
+    void appendJsonField(std::string_view key, std::string_view value) {
+        out.push_back('"');
+        out.append(key);
+        out.append("\":");
+        appendJsonString(value);
+    }
+
+    // Copies runs of plain characters at once and escapes the rest
+    void appendJsonString(std::string_view text) {
+        static const char hex[] = "0123456789abcdef";
+        out.push_back('"');
+        size_t plainStart = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            out.append(text.substr(plainStart, i - plainStart));
+            plainStart = i + 1;
+            if (c == '"' || c == '\\') {
+                out.push_back('\\');
+                out.push_back(static_cast<char>(c));
+            } else {
+                char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+                out.append(escaped, sizeof(escaped));
+            }
+        }
+        out.append(text.substr(plainStart));
+        out.push_back('"');
+    }
+
+    FeedFormat format;
+    std::string& out;
+};
+
+// A serialized feed as a list of buffers: the chunks written in parallel
+// plus the framing between them. The pieces are never joined; writeTo()
+// hands them to the kernel with writev().
+class SerializedFeed {
+public:
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& piece : pieces) {
+            total += piece.size();
+        }
+        return total;
+    }
+
+    const std::vector<std::string>& getPieces() const {
+        return pieces;
+    }
+
+    // Returns false on a write error
+    bool writeTo(int fd) const {
+        std::vector<iovec> buffers;
+        for (const auto& piece : pieces) {
+            buffers.push_back(iovec{const_cast<char*>(piece.data()), piece.size()});
+        }
+        size_t next = 0;
+        while (next < buffers.size()) {
+            int count = static_cast<int>(std::min<size_t>(buffers.size() - next, IOV_MAX));
+            ssize_t written = ::writev(fd, buffers.data() + next, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            // Skip what was written, resuming mid-buffer after a short write
+            size_t remaining = static_cast<size_t>(written);
+            while (next < buffers.size() && remaining >= buffers[next].iov_len) {
+                remaining -= buffers[next].iov_len;
+                ++next;
+            }
+            if (remaining > 0) {
+                buffers[next].iov_base = static_cast<char*>(buffers[next].iov_base) + remaining;
+                buffers[next].iov_len -= remaining;
+            }
+        }
+        return true;
+    }
+
+private:
+    friend SerializedFeed serializeFeed(const std::vector<std::unique_ptr<InstagramPost>>& posts,
+                                        FeedFormat format, unsigned threadCount);
+
+    std::vector<std::string> pieces;
+};
+
+// Serializes a feed, one contiguous range of posts per thread. A binary feed
+// starts with the magic "IGFD" and a varint post count; a JSON feed is an
+// array of post objects.
+SerializedFeed serializeFeed(const std::vector<std::unique_ptr<InstagramPost>>& posts, FeedFormat format,
+                             unsigned threadCount) {
+    threadCount = std::max(1u, std::min<unsigned>(threadCount, static_cast<unsigned>(posts.size())));
+    size_t perThread = posts.empty() ? 0 : (posts.size() + threadCount - 1) / threadCount;
+    std::vector<std::string> chunks(threadCount);
+    auto writeRange = [&](unsigned chunk) {
+        size_t begin = std::min(posts.size(), chunk * perThread);
+        size_t end = std::min(posts.size(), begin + perThread);
+        FeedWriter writer(format, chunks[chunk]);
+        for (size_t i = begin; i < end; ++i) {
+            if (format == FeedFormat::Json && i > begin) {
+                chunks[chunk].push_back(',');
+            }
+            writer.writePost(*posts[i]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threadCount; ++t) {
+        workers.emplace_back(writeRange, t);
+    }
+    writeRange(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    SerializedFeed feed;
+    std::string header;
+    if (format == FeedFormat::Binary) {
+        header = "IGFD";
+        FeedWriter(format, header).appendVarint(posts.size());
+    } else {
+        header = "[";
+    }
+    feed.pieces.push_back(std::move(header));
+    for (auto& chunk : chunks) {
+        if (chunk.empty()) {
+            continue;
+        }
+        if (format == FeedFormat::Json && feed.pieces.size() > 1) {
+            feed.pieces.emplace_back(",");
+        }
+        feed.pieces.push_back(std::move(chunk));
+    }
+    if (format == FeedFormat::Json) {
+        feed.pieces.emplace_back("]");
+    }
+    return feed;
+}
+
+// Sorted post ids, stored as varint-encoded gaps: ids that are close
+// together take one byte each
+class PostingList {
+public:
+    // Ids must be appended in increasing order
+    void append(uint32_t postId) {
+        uint32_t gap = postId - lastId;
+        while (gap >= 0x80) {
+            bytes.push_back(static_cast<char>(gap | 0x80));
+            gap >>= 7;
+        }
+        bytes.push_back(static_cast<char>(gap));
+        lastId = postId;
+        ++count;
+    }
+
+    void decode(std::vector<uint32_t>& ids) const {
+        ids.clear();
+        ids.reserve(count);
+        uint32_t id = 0;
+        for (size_t i = 0; i < bytes.size();) {
+            uint32_t gap = 0;
+            for (unsigned shift = 0;; shift += 7) {
+                uint8_t byte = static_cast<uint8_t>(bytes[i++]);
+                gap |= uint32_t(byte & 0x7f) << shift;
+                if (byte < 0x80) {
+                    break;
+                }
+            }
+            id += gap;
+            ids.push_back(id);
         }
     }
+
+    size_t size() const { return count; }
+    size_t encodedBytes() const { return bytes.size(); }
+
+private:
+    std::string bytes;
+    uint32_t lastId = 0;
+    size_t count = 0;
+};
+
+// Intersects two sorted lists of unique ids into out. With SSE2, blocks of
+// four ids are compared all-against-all using three rotations of one block;
+// a very short list is instead looked up in the long one by binary search.
+void intersectSorted(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, std::vector<uint32_t>& out) {
+    out.clear();
+    const std::vector<uint32_t>& small = a.size() <= b.size() ? a : b;
+    const std::vector<uint32_t>& large = a.size() <= b.size() ? b : a;
+    if (small.size() * 32 < large.size()) {
+        auto from = large.begin();
+        for (uint32_t id : small) {
+            from = std::lower_bound(from, large.end(), id);
+            if (from == large.end()) {
+                break;
+            }
+            if (*from == id) {
+                out.push_back(id);
+            }
+        }
+        return;
+    }
+    size_t i = 0;
+    size_t j = 0;
+#if defined(__SSE2__)
+    while (i + 4 <= a.size() && j + 4 <= b.size()) {
+        __m128i blockA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + i));
+        __m128i blockB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + j));
+        __m128i equal = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(blockA, blockB),
+                         _mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, _MM_SHUFFLE(2, 1, 0, 3)))));
+        int matches = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        for (int lane = 0; lane < 4; ++lane) {
+            if (matches & (1 << lane)) {
+                out.push_back(a[i + lane]);
+            }
+        }
+        uint32_t lastA = a[i + 3];
+        uint32_t lastB = b[j + 3];
+        i += lastA <= lastB ? 4 : 0;
+        j += lastB <= lastA ? 4 : 0;
+    }
+#endif
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            out.push_back(a[i]);
+            ++i;
+            ++j;
+        }
+    }
+}
+
+// Inverted index from hashtag to the posts carrying it. Hashtags are
+// interned to dense ids; posts are numbered in the order they are added,
+// which keeps every posting list sorted by construction. Not thread-safe.
+class HashtagIndex {
+public:
+    // Indexes the post's Tags components and returns its post id
+    uint32_t addPost(const InstagramPost& post) {
+        uint32_t postId = postCount++;
+        postTags.clear();
+        for (const auto& component : post.getComponents()) {
+            if (const Tags* tags = std::get_if<Tags>(&component)) {
+                for (const auto& tag : tags->tags) {
+                    postTags.push_back(intern(tag));
+                }
+            }
+        }
+        std::sort(postTags.begin(), postTags.end());
+        postTags.erase(std::unique(postTags.begin(), postTags.end()), postTags.end());
+        for (uint32_t tagId : postTags) {
+            postings[tagId].append(postId);
+        }
+        return postId;
+    }
+
+    // Ids of the posts carrying every one of the tags, in increasing order
+    std::vector<uint32_t> search(std::initializer_list<std::string_view> tags) const {
+        std::vector<const PostingList*> lists;
+        for (auto tag : tags) {
+            auto it = tagIds.find(tag);
+            if (it == tagIds.end()) {
+                return {};
+            }
+            lists.push_back(&postings[it->second]);
+        }
+        if (lists.empty()) {
+            return {};
+        }
+        // Shortest list first, so every intermediate result stays small
+        std::sort(lists.begin(), lists.end(), [](const PostingList* x, const PostingList* y) {
+            return x->size() < y->size();
+        });
+        std::vector<uint32_t> result;
+        std::vector<uint32_t> next;
+        std::vector<uint32_t> merged;
+        lists.front()->decode(result);
+        for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+            lists[i]->decode(next);
+            intersectSorted(result, next, merged);
+            result.swap(merged);
+        }
+        return result;
+    }
+
+    size_t tagCount() const { return tagNames.size(); }
+    size_t size() const { return postCount; }
+
+    // Total posting entries and their encoded size
+    std::pair<size_t, size_t> postingStats() const {
+        size_t entries = 0;
+        size_t bytes = 0;
+        for (const auto& list : postings) {
+            entries += list.size();
+            bytes += list.encodedBytes();
+        }
+        return {entries, bytes};
+    }
+
+private:
+    uint32_t intern(const std::string& tag) {
+        auto it = tagIds.find(tag);
+        if (it != tagIds.end()) {
+            return it->second;
+        }
+        uint32_t tagId = static_cast<uint32_t>(tagNames.size());
+        tagNames.push_back(tag);
+        tagIds.emplace(tagNames.back(), tagId);  // the deque keeps the viewed string in place
+        postings.emplace_back();
+        return tagId;
+    }
+
+    std::deque<std::string> tagNames;
+    std::unordered_map<std::string_view, uint32_t> tagIds;
+    std::vector<PostingList> postings;
+    std::vector<uint32_t> postTags;
+    uint32_t postCount = 0;
 };
 
 // Builder interface
+// Each string setter has three overloads: an rvalue std::string is moved in,
+// a string_view or C string is copied once.
 class InstagramPostBuilder {
 public:
     virtual ~InstagramPostBuilder() {}
-    virtual InstagramPostBuilder& addImage(const std::string& url) = 0;
-    virtual InstagramPostBuilder& addCaption(const std::string& text) = 0;
-    virtual InstagramPostBuilder& addLocation(const std::string& place) = 0;
-    virtual InstagramPostBuilder& addTags(const std::vector<std::string>& tags) = 0;
-    virtual InstagramPostBuilder& setVisibility(const std::string& visibility) = 0;
+    virtual InstagramPostBuilder& addImage(std::string&& url) = 0;
+    virtual InstagramPostBuilder& addCaption(std::string&& text) = 0;
+    virtual InstagramPostBuilder& addLocation(std::string&& place) = 0;
+    virtual InstagramPostBuilder& addTags(std::vector<std::string>&& tags) = 0;
+    virtual InstagramPostBuilder& setVisibility(std::string&& visibility) = 0;
     virtual std::unique_ptr<InstagramPost> build() = 0;
+
+    InstagramPostBuilder& addImage(std::string_view url) { return addImage(std::string(url)); }
+    InstagramPostBuilder& addImage(const char* url) { return addImage(std::string(url)); }
+    InstagramPostBuilder& addCaption(std::string_view text) { return addCaption(std::string(text)); }
+    InstagramPostBuilder& addCaption(const char* text) { return addCaption(std::string(text)); }
+    InstagramPostBuilder& addLocation(std::string_view place) { return addLocation(std::string(place)); }
+    InstagramPostBuilder& addLocation(const char* place) { return addLocation(std::string(place)); }
+    InstagramPostBuilder& setVisibility(std::string_view visibility) { return setVisibility(std::string(visibility)); }
+    InstagramPostBuilder& setVisibility(const char* visibility) { return setVisibility(std::string(visibility)); }
+
+    InstagramPostBuilder& addTags(const std::vector<std::string>& tags) {
+        return addTags(std::vector<std::string>(tags));
+    }
+
+    InstagramPostBuilder& addTags(std::initializer_list<std::string_view> tags) {
+        std::vector<std::string> copies;
+        copies.reserve(tags.size());
+        for (auto tag : tags) {
+            copies.emplace_back(tag);
+        }
+        return addTags(std::move(copies));
+    }
 };
 
 // Concrete builder implementation
+// Building a post allocates the post and its component vector; moved-in
+// strings and tag lists are not copied. Given an index, build() adds the
+// post to it, so its post id is its position in build order.
 class ConcreteInstagramPostBuilder : public InstagramPostBuilder {
 private:
     std::unique_ptr<InstagramPost> post;
+    HashtagIndex* index;
 
 public:
-    ConcreteInstagramPostBuilder() : post(new InstagramPost()) {}
+    // Overriding the rvalue setters would otherwise hide the copying overloads
+    using InstagramPostBuilder::addImage;
+    using InstagramPostBuilder::addCaption;
+    using InstagramPostBuilder::addLocation;
+    using InstagramPostBuilder::addTags;
+    using InstagramPostBuilder::setVisibility;
+
+    explicit ConcreteInstagramPostBuilder(HashtagIndex* index = nullptr) : post(new InstagramPost()), index(index) {
+        post->reserveComponents(std::variant_size_v<PostComponent>);
+    }
 
-    InstagramPostBuilder& addImage(const std::string& url) override {
-        post->addComponent(std::make_unique<Image>(url));
+    InstagramPostBuilder& addImage(std::string&& url) override {
+        post->emplaceComponent<Image>(std::move(url));
         return *this;
     }
 
-    InstagramPostBuilder& addCaption(const std::string& text) override {
-        post->addComponent(std::make_unique<Caption>(text));
+    InstagramPostBuilder& addCaption(std::string&& text) override {
+        post->emplaceComponent<Caption>(std::move(text));
         return *this;
     }
 
-    InstagramPostBuilder& addLocation(const std::string& place) override {
-        post->addComponent(std::make_unique<Location>(place));
+    InstagramPostBuilder& addLocation(std::string&& place) override {
+        post->emplaceComponent<Location>(std::move(place));
         return *this;
     }
 
-    InstagramPostBuilder& addTags(const std::vector<std::string>& tags) override {
-        post->addComponent(std::make_unique<Tags>(tags));
+    InstagramPostBuilder& addTags(std::vector<std::string>&& tags) override {
+        post->emplaceComponent<Tags>(std::move(tags));
         return *this;
     }
 
-    InstagramPostBuilder& setVisibility(const std::string& visibility) override {
-        post->addComponent(std::make_unique<Visibility>(visibility));
+    InstagramPostBuilder& setVisibility(std::string&& visibility) override {
+        post->emplaceComponent<Visibility>(std::move(visibility));
         return *this;
     }
 
     std::unique_ptr<InstagramPost> build() override {
+        if (index != nullptr && post) {
+            index->addPost(*post);
+        }
         return std::move(post);
     }
 };
 
+// Fields tracked by StaticInstagramPostBuilder; a post needs an image
+namespace InstagramPostField {
+    constexpr uint32_t Image = 1;
+}
+
+// Compile-time checked post builder: build() does not compile until an image
+// has been added
+template <uint32_t Set = 0>
+class StaticInstagramPostBuilder
+    : public StaticBuilder<StaticInstagramPostBuilder, InstagramPost, InstagramPostField::Image, Set> {
+public:
+    StaticInstagramPostBuilder() {
+        this->product->reserveComponents(std::variant_size_v<PostComponent>);
+    }
+
+    explicit StaticInstagramPostBuilder(std::unique_ptr<InstagramPost> partial)
+        : StaticInstagramPostBuilder::StaticBuilder(std::move(partial)) {}
+
+    auto addImage(std::string url) && {
+        this->product->template emplaceComponent<Image>(std::move(url));
+        return this->template with<InstagramPostField::Image>();
+    }
+
+    auto addCaption(std::string text) && {
+        this->product->template emplaceComponent<Caption>(std::move(text));
+        return this->template with<0>();
+    }
+
+    auto addLocation(std::string place) && {
+        this->product->template emplaceComponent<Location>(std::move(place));
+        return this->template with<0>();
+    }
+
+    auto addTags(std::vector<std::string> tags) && {
+        this->product->template emplaceComponent<Tags>(std::move(tags));
+        return this->template with<0>();
+    }
+
+    auto setVisibility(std::string visibility) && {
+        this->product->template emplaceComponent<Visibility>(std::move(visibility));
+        return this->template with<0>();
+    }
+};
+
+static_assert(!CanBuild<decltype(StaticInstagramPostBuilder<>().addCaption("No image"))>,
+              "A post without an image must not build");
+
 // Example usage
 int main() {
     ConcreteInstagramPostBuilder builder;
@@ -141,5 +670,168 @@ int main() {
                        .setVisibility("Public")
                        .build();
     post->display();
+
+    std::vector<std::unique_ptr<InstagramPost>> sample;
+    sample.push_back(std::move(post));
+    SerializedFeed sampleFeed = serializeFeed(sample, FeedFormat::Json, 1);
+    std::string json;
+    for (const auto& piece : sampleFeed.getPieces()) {
+        json += piece;
+    }
+    std::cout << json << std::endl;
+
+    // The same post through the compile-time checked builder, against the virtual one
+    const size_t buildCount = 1000000;
+    size_t componentCount = 0;
+    double virtualNs = nanosecondsPerBuild(buildCount, [&](size_t) {
+        componentCount += ConcreteInstagramPostBuilder()
+                              .addImage("http://example.com/image1.jpg")
+                              .addCaption("Enjoying the beautiful views!")
+                              .addLocation("New York, USA")
+                              .setVisibility("Public")
+                              .build()
+                              ->getComponents()
+                              .size();
+    });
+    double staticNs = nanosecondsPerBuild(buildCount, [&](size_t) {
+        componentCount += StaticInstagramPostBuilder<>()
+                              .addImage("http://example.com/image1.jpg")
+                              .addCaption("Enjoying the beautiful views!")
+                              .addLocation("New York, USA")
+                              .setVisibility("Public")
+                              .build()
+                              ->getComponents()
+                              .size();
+    });
+    std::cout << "Virtual post builder: " << virtualNs << " ns per post, static builder: " << staticNs
+              << " ns (" << componentCount << " components)" << std::endl;
+
+    // Build 1M posts from moved-in strings; the inputs are prepared first so
+    // only the builder's own allocations are counted
+    const size_t postCount = 1000000;
+    struct PostInput {
+        std::string url;
+        std::string caption;
+        std::vector<std::string> tags;
+    };
+    std::vector<PostInput> inputs(postCount);
+    for (size_t i = 0; i < postCount; ++i) {
+        inputs[i].url = "http://example.com/images/" + std::to_string(i) + ".jpg";
+        inputs[i].caption = "Post number " + std::to_string(i) + " from the benchmark feed";
+        inputs[i].tags = {"travel", "photography", "benchmark"};
+    }
+    std::vector<std::unique_ptr<InstagramPost>> feedPosts;
+    feedPosts.reserve(postCount);
+    size_t allocationsBefore = allocationCount();  // counted after reserving the feed
+    auto start = std::chrono::steady_clock::now();
+    for (auto& input : inputs) {
+        feedPosts.push_back(ConcreteInstagramPostBuilder()
+                                 .addImage(std::move(input.url))
+                                 .addCaption(std::move(input.caption))
+                                 .addLocation("New York, USA")
+                                 .addTags(std::move(input.tags))
+                                 .setVisibility("Public")
+                                 .build());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Built " << feedPosts.size() << " posts in " << seconds * 1000 << " ms, "
+              << static_cast<double>(allocationCount() - allocationsBefore) / postCount
+              << " allocations per post" << std::endl;
+
+    // Serialize the feed in both formats, sequentially and in parallel, and
+    // write it out with one gathered write
+    int output = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    for (FeedFormat format : {FeedFormat::Binary, FeedFormat::Json}) {
+        std::string sequential;
+        for (unsigned threads : {1u, 4u}) {
+            start = std::chrono::steady_clock::now();
+            SerializedFeed feed = serializeFeed(feedPosts, format, threads);
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::string joined;
+            for (const auto& piece : feed.getPieces()) {
+                joined += piece;
+            }
+            if (threads == 1) {
+                sequential = std::move(joined);
+            }
+            bool written = feed.writeTo(output);
+            std::cout << (format == FeedFormat::Binary ? "Binary" : "JSON") << " feed on " << threads
+                      << " thread(s): " << feed.size() / (1024 * 1024) << " MB in " << seconds * 1000 << " ms, "
+                      << feed.getPieces().size() << " pieces"
+                      << (threads == 1 || joined == sequential ? "" : " (DIFFERS FROM SEQUENTIAL)")
+                      << (written ? "" : " (WRITE FAILED)") << std::endl;
+        }
+    }
+    ::close(output);
+
+    // Index hashtags as posts are built, then search for posts with several tags
+    feedPosts.clear();
+    HashtagIndex hashtags;
+    std::vector<std::string> vocabulary;
+    for (int i = 0; i < 2000; ++i) {
+        vocabulary.push_back("tag" + std::to_string(i));
+    }
+    uint64_t seed = 12345;
+    auto nextRandom = [&seed] {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<uint32_t>(seed >> 33);
+    };
+    const size_t indexedCount = 500000;
+    std::vector<std::unique_ptr<InstagramPost>> indexedPosts;
+    indexedPosts.reserve(indexedCount);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < indexedCount; ++i) {
+        std::vector<std::string> tags;
+        for (int t = 0; t < 5; ++t) {
+            // Skewed towards low tag numbers, like real hashtags
+            uint32_t rank = nextRandom() % 2000;
+            tags.push_back(vocabulary[rank * rank / 2000]);
+        }
+        indexedPosts.push_back(ConcreteInstagramPostBuilder(&hashtags)
+                                   .addImage("http://example.com/images/" + std::to_string(i) + ".jpg")
+                                   .addTags(std::move(tags))
+                                   .build());
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto [entries, encodedBytes] = hashtags.postingStats();
+    std::cout << "Indexed " << hashtags.size() << " posts, " << hashtags.tagCount() << " tags in "
+              << seconds * 1000 << " ms; " << entries << " postings in " << encodedBytes << " bytes ("
+              << static_cast<double>(encodedBytes) / entries << " bytes each)" << std::endl;
+
+    auto hasTag = [](const InstagramPost& candidate, std::string_view tag) {
+        for (const auto& component : candidate.getComponents()) {
+            if (const Tags* tags = std::get_if<Tags>(&component)) {
+                if (std::find(tags->tags.begin(), tags->tags.end(), tag) != tags->tags.end()) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    for (auto query : {std::initializer_list<std::string_view>{"tag0", "tag1"},
+                       std::initializer_list<std::string_view>{"tag0", "tag3", "tag10"},
+                       std::initializer_list<std::string_view>{"tag0", "tag1998"}}) {
+        const int repetitions = 100;
+        std::vector<uint32_t> found;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repetitions; ++r) {
+            found = hashtags.search(query);
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+        size_t expected = 0;
+        for (const auto& candidate : indexedPosts) {
+            bool all = true;
+            for (auto tag : query) {
+                all = all && hasTag(*candidate, tag);
+            }
+            expected += all;
+        }
+        std::cout << "Search";
+        for (auto tag : query) {
+            std::cout << " #" << tag;
+        }
+        std::cout << ": " << found.size() << " posts in " << seconds * 1e6 << " us"
+                  << (found.size() == expected ? "" : " (EXPECTED " + std::to_string(expected) + ")") << std::endl;
+    }
     return 0;
 }
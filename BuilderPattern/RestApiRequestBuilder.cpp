@@ -2,6 +2,138 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../Common/AllocationCounter.h"
+#include "../Common/Benchmark.h"
+#include "StaticBuilder.h"
+
+// Streamed request body that is never held in a std::string. Known-length
+// sources (file descriptor, mapped file) are sent with Content-Length, the
+// file descriptor one through sendfile(); generators are sent with chunked
+// transfer encoding.
+class BodySource {
+public:
+    enum Kind {
+        FileDescriptor,
+        MappedFile,
+        Generator
+    };
+
+    // Fills buffer with up to capacity bytes and returns the count; 0 ends the body
+    using GenerateFunction = std::function<size_t(char* buffer, size_t capacity)>;
+
+    // The caller keeps fd open until the request has been sent
+    static std::shared_ptr<BodySource> fromFileDescriptor(int fd, off_t offset, size_t length) {
+        auto source = std::shared_ptr<BodySource>(new BodySource(FileDescriptor));
+        source->fd = fd;
+        source->offset = offset;
+        source->size = length;
+        return source;
+    }
+
+    // Maps the whole file read-only; it is unmapped when the last reference goes
+    static std::shared_ptr<BodySource> fromMappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open body file: " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat body file: " + path);
+        }
+        auto source = std::shared_ptr<BodySource>(new BodySource(MappedFile));
+        source->size = static_cast<size_t>(info.st_size);
+        if (source->size > 0) {
+            void* mapped = ::mmap(nullptr, source->size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map body file: " + path);
+            }
+            ::madvise(mapped, source->size, MADV_SEQUENTIAL);
+            source->mapped = static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+        return source;
+    }
+
+    // A generator is single-shot: it can be sent by one request only, and
+    // submitting a second request with the same source throws
+    static std::shared_ptr<BodySource> fromGenerator(GenerateFunction generator) {
+        auto source = std::shared_ptr<BodySource>(new BodySource(Generator));
+        source->generator = std::move(generator);
+        return source;
+    }
+
+    ~BodySource() {
+        if (mapped != nullptr) {
+            ::munmap(const_cast<char*>(mapped), size);
+        }
+    }
+
+    BodySource(const BodySource&) = delete;
+    BodySource& operator=(const BodySource&) = delete;
+
+    Kind getKind() const { return kind; }
+    bool hasKnownLength() const { return kind != Generator; }
+    size_t length() const { return size; }
+    int fileDescriptor() const { return fd; }
+    off_t fileOffset() const { return offset; }
+    const char* mappedData() const { return mapped; }
+    size_t generate(char* buffer, size_t capacity) const { return generator(buffer, capacity); }
+
+    // Marks a generator as taken by a request; false if it was taken before.
+    // Known-length sources can be sent any number of times.
+    bool claim() {
+        return kind != Generator || !claimed.exchange(true);
+    }
+
+private:
+    explicit BodySource(Kind kind) : kind(kind) {}
+
+    Kind kind;
+    int fd = -1;
+    off_t offset = 0;
+    size_t size = 0;
+    const char* mapped = nullptr;
+    GenerateFunction generator;
+    std::atomic<bool> claimed{false};
+};
 
 // Represents an HTTP request
 class HttpRequest {
@@ -10,6 +142,8 @@ public:
     std::string url;
     std::map<std::string, std::string> headers;
     std::string body;
+    // Streamed body; takes precedence over body when set
+    std::shared_ptr<BodySource> bodySource;
 
     void send() const {
         std::cout << "Sending " << method << " request to " << url << std::endl;
@@ -17,7 +151,13 @@ public:
         for (const auto& header : headers) {
             std::cout << header.first << ": " << header.second << std::endl;
         }
-        if (!body.empty()) {
+        if (bodySource) {
+            if (bodySource->hasKnownLength()) {
+                std::cout << "Body: <streamed, " << bodySource->length() << " bytes>" << std::endl;
+            } else {
+                std::cout << "Body: <streamed, chunked>" << std::endl;
+            }
+        } else if (!body.empty()) {
             std::cout << "Body: " << body << std::endl;
         }
     }
@@ -30,6 +170,7 @@ public:
     virtual HttpRequestBuilder& setUrl(const std::string& url) = 0;
     virtual HttpRequestBuilder& addHeader(const std::string& key, const std::string& value) = 0;
     virtual HttpRequestBuilder& setBody(const std::string& body) = 0;
+    virtual HttpRequestBuilder& setBodySource(std::shared_ptr<BodySource> source) = 0;
     virtual std::unique_ptr<HttpRequest> build() = 0;
 };
 
@@ -61,11 +202,1034 @@ public:
         return *this;
     }
 
+    HttpRequestBuilder& setBodySource(std::shared_ptr<BodySource> source) override {
+        httpRequest->bodySource = std::move(source);
+        return *this;
+    }
+
     std::unique_ptr<HttpRequest> build() override {
         return std::move(httpRequest);
     }
 };
 
+// HTTP methods supported by the buffered builder
+enum class HttpMethod {
+    Get,
+    Post,
+    Put,
+    Patch,
+    Delete,
+    Head,
+    Options
+};
+
+inline std::string_view methodName(HttpMethod method) {
+    switch (method) {
+        case HttpMethod::Get: return "GET";
+        case HttpMethod::Post: return "POST";
+        case HttpMethod::Put: return "PUT";
+        case HttpMethod::Patch: return "PATCH";
+        case HttpMethod::Delete: return "DELETE";
+        case HttpMethod::Head: return "HEAD";
+        case HttpMethod::Options: return "OPTIONS";
+    }
+    return "GET";
+}
+
+// Builder mode for hot loops: url, headers and body are appended to one
+// reusable byte buffer and referenced by offset. Headers live in a flat array
+// with inline room for eight before spilling to the heap. reset() keeps all
+// capacity, so building request after request allocates nothing once warm.
+class BufferedHttpRequestBuilder {
+private:
+    struct Slice {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    struct HeaderSlice {
+        Slice key;
+        Slice value;
+    };
+
+    static constexpr size_t inlineHeaderCapacity = 8;
+
+    HttpMethod method = HttpMethod::Get;
+    std::string buffer;
+    Slice url;
+    Slice body;
+    std::array<HeaderSlice, inlineHeaderCapacity> inlineHeaders;
+    std::vector<HeaderSlice> overflowHeaders;
+    size_t headerCount = 0;
+
+    Slice append(std::string_view text) {
+        Slice slice{static_cast<uint32_t>(buffer.size()), static_cast<uint32_t>(text.size())};
+        buffer.append(text);
+        return slice;
+    }
+
+    std::string_view view(Slice slice) const {
+        return std::string_view(buffer.data() + slice.offset, slice.length);
+    }
+
+    HeaderSlice& headerAt(size_t index) {
+        return index < inlineHeaderCapacity ? inlineHeaders[index] : overflowHeaders[index - inlineHeaderCapacity];
+    }
+
+    const HeaderSlice& headerAt(size_t index) const {
+        return index < inlineHeaderCapacity ? inlineHeaders[index] : overflowHeaders[index - inlineHeaderCapacity];
+    }
+
+public:
+    explicit BufferedHttpRequestBuilder(size_t initialCapacity = 1024) {
+        buffer.reserve(initialCapacity);
+    }
+
+    BufferedHttpRequestBuilder& setMethod(HttpMethod newMethod) {
+        method = newMethod;
+        return *this;
+    }
+
+    BufferedHttpRequestBuilder& setUrl(std::string_view newUrl) {
+        url = append(newUrl);
+        return *this;
+    }
+
+    // Same semantics as the map-based builder: a repeated key replaces the value
+    BufferedHttpRequestBuilder& addHeader(std::string_view key, std::string_view value) {
+        for (size_t i = 0; i < headerCount; ++i) {
+            if (view(headerAt(i).key) == key) {
+                headerAt(i).value = append(value);
+                return *this;
+            }
+        }
+        HeaderSlice header{append(key), append(value)};
+        if (headerCount < inlineHeaderCapacity) {
+            inlineHeaders[headerCount] = header;
+        } else {
+            overflowHeaders.push_back(header);
+        }
+        ++headerCount;
+        return *this;
+    }
+
+    BufferedHttpRequestBuilder& setBody(std::string_view newBody) {
+        body = append(newBody);
+        return *this;
+    }
+
+    // Clears the request but keeps buffer and header capacity for the next one
+    void reset() {
+        method = HttpMethod::Get;
+        buffer.clear();
+        url = Slice();
+        body = Slice();
+        overflowHeaders.clear();
+        headerCount = 0;
+    }
+
+    HttpMethod getMethod() const { return method; }
+    std::string_view getUrl() const { return view(url); }
+    std::string_view getBody() const { return view(body); }
+    size_t getHeaderCount() const { return headerCount; }
+    std::string_view getHeaderKey(size_t index) const { return view(headerAt(index).key); }
+    std::string_view getHeaderValue(size_t index) const { return view(headerAt(index).value); }
+
+    // Copies the buffered request into the classic HttpRequest
+    std::unique_ptr<HttpRequest> build() const {
+        auto request = std::make_unique<HttpRequest>();
+        request->method = methodName(method);
+        request->url = getUrl();
+        for (size_t i = 0; i < headerCount; ++i) {
+            request->headers[std::string(getHeaderKey(i))] = getHeaderValue(i);
+        }
+        request->body = getBody();
+        return request;
+    }
+};
+
+// Parsed "http://host[:port]/path" URL; https is not supported by the executor
+struct HttpTarget {
+    std::string host;
+    uint16_t port = 80;
+    std::string path;
+};
+
+inline HttpTarget parseHttpUrl(const std::string& url) {
+    const std::string scheme = "http://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        throw std::invalid_argument("Only http:// URLs are supported: " + url);
+    }
+    size_t hostStart = scheme.size();
+    size_t pathStart = url.find('/', hostStart);
+    std::string authority = url.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+    HttpTarget target;
+    target.path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+    size_t colon = authority.find(':');
+    target.host = authority.substr(0, colon);
+    if (colon != std::string::npos) {
+        std::string_view port = std::string_view(authority).substr(colon + 1);
+        int value = 0;
+        auto [end, error] = std::from_chars(port.data(), port.data() + port.size(), value);
+        if (port.empty() || error != std::errc() || end != port.data() + port.size() || value < 1 || value > 65535) {
+            throw std::invalid_argument("URL has an invalid port: " + url);
+        }
+        target.port = static_cast<uint16_t>(value);
+    }
+    if (target.host.empty()) {
+        throw std::invalid_argument("URL has no host: " + url);
+    }
+    return target;
+}
+
+// Appends the HTTP/1.1 wire form of the request to out. For a streamed body
+// only the head is written; the executor sends the body from its source.
+inline void serializeRequest(const HttpRequest& request, const HttpTarget& target, std::string& out) {
+    out.append(request.method).append(" ").append(target.path).append(" HTTP/1.1\r\n");
+    out.append("Host: ").append(target.host);
+    if (target.port != 80) {
+        out.append(":").append(std::to_string(target.port));
+    }
+    out.append("\r\n");
+    for (const auto& header : request.headers) {
+        out.append(header.first).append(": ").append(header.second).append("\r\n");
+    }
+    if (request.bodySource && !request.bodySource->hasKnownLength()) {
+        out.append("Transfer-Encoding: chunked\r\n\r\n");
+        return;
+    }
+    if (request.bodySource) {
+        out.append("Content-Length: ").append(std::to_string(request.bodySource->length())).append("\r\n\r\n");
+        return;
+    }
+    if (!request.body.empty() || request.method == "POST" || request.method == "PUT") {
+        out.append("Content-Length: ").append(std::to_string(request.body.size())).append("\r\n");
+    }
+    out.append("\r\n").append(request.body);
+}
+
+struct HttpResponse {
+    int statusCode = 0;  // 0 when the request failed before a response arrived
+    std::string body;
+    std::string error;
+};
+
+// One message framed by HttpMessageParser. head and body view the parsed data.
+struct HttpMessage {
+    std::string_view head;
+    std::string_view body;         // Content-Length or read-until-close body; empty when chunked
+    size_t bodyLength = 0;         // body size, for a chunked body the decoded size
+    bool chunked = false;
+    bool closeConnection = false;  // the sender closes the connection after this message
+    std::string decodedBody;       // chunked body, when decoding was asked for
+};
+
+// Incremental parser for one HTTP/1.1 message: a head followed by a
+// Content-Length body, a chunked body or, for responses only, a body that
+// runs until the connection closes. Used for responses by the executor and
+// for requests by the loopback server.
+struct HttpMessageParser {
+    // Returned instead of a size when the message cannot be framed, e.g. a
+    // non-numeric Content-Length or chunk size; the connection is unusable
+    static constexpr size_t malformed = static_cast<size_t>(-1);
+
+    // Returns the size of the first complete request in data, 0 if incomplete,
+    // or malformed. A request without Content-Length or chunked encoding has
+    // no body. Chunks are only counted unless decodeChunks is set.
+    static size_t completeMessageSize(std::string_view data, HttpMessage& message, bool decodeChunks = false) {
+        size_t contentLength = 0;
+        bool hasLength = false;
+        size_t headSize = readHead(data, message, contentLength, hasLength);
+        if (headSize == 0 || headSize == malformed) {
+            return headSize;
+        }
+        return frameBody(data, headSize, contentLength, message, decodeChunks);
+    }
+
+    // Like completeMessageSize, for a response to a request with the given
+    // method; a chunked body is decoded into message.decodedBody. Responses
+    // to HEAD and 1xx, 204 and 304 responses end at the head whatever their
+    // Content-Length or Transfer-Encoding say. A response with neither runs
+    // until the connection closes, so it is complete only once closed is set.
+    static size_t completeResponseSize(std::string_view data, bool headRequest, bool closed, HttpMessage& message) {
+        size_t contentLength = 0;
+        bool hasLength = false;
+        size_t headSize = readHead(data, message, contentLength, hasLength);
+        if (headSize == 0 || headSize == malformed) {
+            return headSize;
+        }
+        int status = statusCode(message.head);
+        if (status == 0) {
+            return malformed;
+        }
+        if (headRequest || status < 200 || status == 204 || status == 304) {
+            message.chunked = false;
+            message.body = std::string_view();
+            message.bodyLength = 0;
+            return headSize;
+        }
+        if (!message.chunked && !hasLength) {
+            if (!closed) {
+                return 0;
+            }
+            contentLength = data.size() - headSize;
+            message.closeConnection = true;
+        }
+        return frameBody(data, headSize, contentLength, message, true);
+    }
+
+    // Status code of a response head such as "HTTP/1.1 200 OK", or 0 if it has none
+    static int statusCode(std::string_view head) {
+        size_t space = head.find(' ');
+        if (space == std::string_view::npos || head.size() < space + 4) {
+            return 0;
+        }
+        size_t status = 0;
+        if (!parseNumber(head.substr(space + 1, 3), 10, status) || status < 100) {
+            return 0;
+        }
+        return static_cast<int>(status);
+    }
+
+private:
+    // True if the whole of text is a number in base; no sign, no whitespace
+    static bool parseNumber(std::string_view text, int base, size_t& value) {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+        return !text.empty() && error == std::errc() && end == text.data() + text.size();
+    }
+
+    // Parses the head's framing headers; returns the head size including the
+    // blank line, 0 if incomplete, or malformed
+    static size_t readHead(std::string_view data, HttpMessage& message, size_t& contentLength, bool& hasLength) {
+        size_t headEnd = data.find("\r\n\r\n");
+        if (headEnd == std::string_view::npos) {
+            return 0;
+        }
+        message.head = data.substr(0, headEnd);
+        message.chunked = false;
+        message.closeConnection = false;
+        size_t lineStart = message.head.find("\r\n");
+        while (lineStart != std::string_view::npos) {
+            lineStart += 2;
+            size_t lineEnd = message.head.find("\r\n", lineStart);
+            std::string_view line = message.head.substr(lineStart, lineEnd == std::string_view::npos ? std::string_view::npos : lineEnd - lineStart);
+            if (line.size() > 15 && strncasecmp(line.data(), "Content-Length:", 15) == 0) {
+                if (!parseNumber(trim(line.substr(15)), 10, contentLength)) {
+                    return malformed;
+                }
+                hasLength = true;
+            } else if (line.size() > 18 && strncasecmp(line.data(), "Transfer-Encoding:", 18) == 0 &&
+                       line.find("chunked") != std::string_view::npos) {
+                message.chunked = true;
+            } else if (line.size() > 11 && strncasecmp(line.data(), "Connection:", 11) == 0) {
+                std::string_view value = trim(line.substr(11));
+                message.closeConnection = value.size() == 5 && strncasecmp(value.data(), "close", 5) == 0;
+            }
+            lineStart = lineEnd;
+        }
+        return headEnd + 4;
+    }
+
+    // Frames the body after the head: chunked, or contentLength bytes
+    static size_t frameBody(std::string_view data, size_t headSize, size_t contentLength,
+                            HttpMessage& message, bool decodeChunks) {
+        if (message.chunked) {
+            message.body = std::string_view();
+            message.bodyLength = 0;
+            size_t total = walkChunks(data, headSize, [&message](std::string_view chunk) {
+                message.bodyLength += chunk.size();
+            });
+            if (decodeChunks && total != 0 && total != malformed) {
+                message.decodedBody.clear();
+                message.decodedBody.reserve(message.bodyLength);
+                walkChunks(data, headSize, [&message](std::string_view chunk) {
+                    message.decodedBody.append(chunk);
+                });
+            }
+            return total;
+        }
+        if (data.size() - headSize < contentLength) {
+            return 0;
+        }
+        message.body = data.substr(headSize, contentLength);
+        message.bodyLength = contentLength;
+        return headSize + contentLength;
+    }
+
+    // Walks "size\r\ndata\r\n" chunks up to the terminating zero-size chunk
+    // (trailers are not supported), calling visit on each chunk's data.
+    // Returns the end of the message, 0 if incomplete, or malformed.
+    template <typename Visit>
+    static size_t walkChunks(std::string_view data, size_t position, Visit visit) {
+        for (;;) {
+            size_t lineEnd = data.find("\r\n", position);
+            if (lineEnd == std::string_view::npos) {
+                return 0;
+            }
+            // Chunk extensions after ';' are ignored
+            std::string_view sizeField = data.substr(position, lineEnd - position);
+            size_t chunkSize = 0;
+            if (!parseNumber(trim(sizeField.substr(0, sizeField.find(';'))), 16, chunkSize)) {
+                return malformed;
+            }
+            if (chunkSize > data.size() || data.size() - lineEnd - 2 < chunkSize + 2) {
+                return 0;
+            }
+            position = lineEnd + 2 + chunkSize + 2;
+            if (chunkSize == 0) {
+                return position;
+            }
+            visit(data.substr(lineEnd + 2, chunkSize));
+        }
+    }
+
+    static std::string_view trim(std::string_view text) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+            text.remove_prefix(1);
+        }
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+};
+
+struct HttpExecutorConfig {
+    size_t connectionsPerHost = 2;
+    size_t maxInFlightPerHost = 32;  // across all of a host's connections
+};
+
+// Sends HttpRequests over pooled keep-alive connections using non-blocking
+// sockets and epoll. Requests to the same host are pipelined on its
+// connections up to maxInFlightPerHost; responses come back in order per
+// connection, so each connection keeps a FIFO of waiting callbacks.
+class HttpExecutor {
+public:
+    using Callback = std::function<void(const HttpResponse&)>;
+
+    explicit HttpExecutor(const HttpExecutorConfig& config = HttpExecutorConfig()) : config(config) {
+        if (config.connectionsPerHost == 0 || config.maxInFlightPerHost == 0) {
+            throw std::invalid_argument("Executor needs at least one connection and one in-flight slot");
+        }
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) {
+            throw std::runtime_error("epoll_create1 failed");
+        }
+    }
+
+    ~HttpExecutor() {
+        for (auto& entry : connections) {
+            ::close(entry.first);
+        }
+        ::close(epollFd);
+    }
+
+    HttpExecutor(const HttpExecutor&) = delete;
+    HttpExecutor& operator=(const HttpExecutor&) = delete;
+
+    // Queues a request; the callback runs from run() once the response arrives
+    void submit(const HttpRequest& request, Callback callback) {
+        HttpTarget target = parseHttpUrl(request.url);
+        Host& host = hostFor(target);
+        Pending pending;
+        serializeRequest(request, target, pending.wire);
+        // Claimed last, so a request rejected above leaves the body usable
+        if (request.bodySource && !request.bodySource->claim()) {
+            throw std::logic_error("Generator body source was already submitted");
+        }
+        pending.bodySource = request.bodySource;
+        pending.callback = std::move(callback);
+        pending.headRequest = request.method == "HEAD";
+        pending.retryable = isIdempotent(request.method) && (!request.bodySource || request.bodySource->hasKnownLength());
+        host.queue.push_back(std::move(pending));
+        ++outstanding;
+        dispatch(host);
+    }
+
+    // Runs the event loop until every submitted request has completed
+    void run() {
+        std::array<epoll_event, 64> events;
+        while (outstanding > 0) {
+            int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("epoll_wait failed");
+            }
+            for (int i = 0; i < count; ++i) {
+                auto it = connections.find(events[i].data.fd);
+                if (it == connections.end()) {
+                    continue;  // closed earlier in this batch
+                }
+                handleEvent(*it->second, events[i].events);
+            }
+        }
+    }
+
+private:
+    struct Pending {
+        std::string wire;
+        std::shared_ptr<BodySource> bodySource;
+        Callback callback;
+        bool headRequest = false;
+        bool retryable = false;  // idempotent, with a body that can be sent again
+        bool retried = false;
+    };
+
+    // Outgoing data in send order: serialized bytes, or a streamed body.
+    // For generator bodies, bytes holds the chunk currently being framed.
+    struct OutSegment {
+        std::string bytes;
+        size_t offset = 0;
+        std::shared_ptr<BodySource> source;
+        size_t sent = 0;
+        bool lastChunk = false;
+    };
+
+    static constexpr size_t chunkCapacity = 64 * 1024;
+    static constexpr size_t chunkHeaderRoom = 10;  // hex length + CRLF
+
+    struct Host;
+
+    struct Connection {
+        int fd = -1;
+        Host* host = nullptr;
+        bool connected = false;
+        bool wantWrite = false;
+        std::deque<OutSegment> out;
+        std::string in;
+        std::deque<Pending> awaiting;  // sent requests, in response order
+        bool closing = false;          // the server announced Connection: close
+    };
+
+    struct Host {
+        HttpTarget target;
+        sockaddr_in address{};
+        std::deque<Pending> queue;
+        std::vector<Connection*> connections;
+        size_t inFlight = 0;
+    };
+
+    Host& hostFor(const HttpTarget& target) {
+        std::string key = target.host + ":" + std::to_string(target.port);
+        auto it = hosts.find(key);
+        if (it != hosts.end()) {
+            return *it->second;
+        }
+        auto host = std::make_unique<Host>();
+        host->target = target;
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(target.host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+            throw std::runtime_error("Cannot resolve host: " + target.host);
+        }
+        host->address = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+        host->address.sin_port = htons(target.port);
+        freeaddrinfo(result);
+        return *hosts.emplace(key, std::move(host)).first->second;
+    }
+
+    Connection& openConnection(Host& host) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "socket failed");
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        int result = ::connect(fd, reinterpret_cast<const sockaddr*>(&host.address), sizeof(host.address));
+        if (result < 0 && errno != EINPROGRESS) {
+            ::close(fd);
+            throw std::runtime_error("connect failed to " + host.target.host);
+        }
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->host = &host;
+        connection->connected = result == 0;
+        connection->wantWrite = true;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        host.connections.push_back(connection.get());
+        return *connections.emplace(fd, std::move(connection)).first->second;
+    }
+
+    // Moves queued requests onto connections while the host has in-flight room
+    void dispatch(Host& host) {
+        while (!host.queue.empty() && host.inFlight < config.maxInFlightPerHost) {
+            Connection* target = nullptr;
+            for (Connection* connection : host.connections) {
+                if (target == nullptr || connection->awaiting.size() < target->awaiting.size()) {
+                    target = connection;
+                }
+            }
+            if (target == nullptr || (!target->awaiting.empty() && host.connections.size() < config.connectionsPerHost)) {
+                target = &openConnection(host);
+            }
+            Pending& pending = host.queue.front();
+            // Consecutive small requests share one segment, so pipelined requests go out together
+            if (target->out.empty() || target->out.back().source) {
+                target->out.emplace_back();
+            }
+            target->out.back().bytes.append(pending.wire);
+            if (pending.bodySource) {
+                target->out.emplace_back();
+                target->out.back().source = pending.bodySource;
+            }
+            target->awaiting.push_back(std::move(pending));
+            host.queue.pop_front();
+            ++host.inFlight;
+            if (target->connected) {
+                flush(*target);
+            }
+        }
+    }
+
+    void setWriteInterest(Connection& connection, bool wantWrite) {
+        if (connection.wantWrite == wantWrite) {
+            return;
+        }
+        connection.wantWrite = wantWrite;
+        epoll_event event{};
+        event.events = EPOLLIN | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        event.data.fd = connection.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+
+    // Returns false if the connection failed and was closed
+    bool flush(Connection& connection) {
+        while (!connection.out.empty()) {
+            OutSegment& segment = connection.out.front();
+            ssize_t written;
+            if (!segment.source || segment.source->getKind() == BodySource::Generator) {
+                if (segment.source && segment.offset == segment.bytes.size()) {
+                    if (segment.lastChunk) {
+                        connection.out.pop_front();
+                        continue;
+                    }
+                    if (!nextChunk(segment)) {
+                        fail(connection, "body generator produced more bytes than it was given", false);
+                        return false;
+                    }
+                }
+                if (segment.offset == segment.bytes.size()) {
+                    connection.out.pop_front();
+                    continue;
+                }
+                written = ::send(connection.fd, segment.bytes.data() + segment.offset,
+                                 segment.bytes.size() - segment.offset, MSG_NOSIGNAL);
+                if (written > 0) {
+                    segment.offset += static_cast<size_t>(written);
+                }
+            } else {
+                const BodySource& source = *segment.source;
+                size_t remaining = source.length() - segment.sent;
+                if (remaining == 0) {
+                    connection.out.pop_front();
+                    continue;
+                }
+                if (source.getKind() == BodySource::FileDescriptor) {
+                    // File pages go to the socket inside the kernel, never through user space
+                    off_t fileOffset = source.fileOffset() + static_cast<off_t>(segment.sent);
+                    written = ::sendfile(connection.fd, source.fileDescriptor(), &fileOffset,
+                                         std::min(remaining, size_t(1) << 30));
+                    if (written == 0) {
+                        fail(connection, "body file is shorter than its declared length", false);
+                        return false;
+                    }
+                } else {
+                    written = ::send(connection.fd, source.mappedData() + segment.sent, remaining, MSG_NOSIGNAL);
+                }
+                if (written > 0) {
+                    segment.sent += static_cast<size_t>(written);
+                }
+            }
+            if (written < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    setWriteInterest(connection, true);
+                    return true;
+                }
+                fail(connection, "send failed", true);
+                return false;
+            }
+        }
+        setWriteInterest(connection, false);
+        return true;
+    }
+
+    // Pulls the next chunk from a generator body and frames it for chunked encoding.
+    // The data is generated after a fixed header gap; the hex header is then
+    // written right before it so the chunk is never copied. Returns false if
+    // the generator claims to have written more than chunkCapacity bytes.
+    static bool nextChunk(OutSegment& segment) {
+        segment.bytes.resize(chunkHeaderRoom + chunkCapacity + 2);
+        size_t produced = segment.source->generate(segment.bytes.data() + chunkHeaderRoom, chunkCapacity);
+        if (produced > chunkCapacity) {
+            return false;
+        }
+        if (produced == 0) {
+            segment.bytes.assign("0\r\n\r\n");
+            segment.offset = 0;
+            segment.lastChunk = true;
+            return true;
+        }
+        char header[chunkHeaderRoom + 1];
+        int headerLength = std::snprintf(header, sizeof(header), "%zx\r\n", produced);
+        segment.offset = chunkHeaderRoom - static_cast<size_t>(headerLength);
+        std::memcpy(segment.bytes.data() + segment.offset, header, static_cast<size_t>(headerLength));
+        segment.bytes.resize(chunkHeaderRoom + produced);
+        segment.bytes.append("\r\n");
+        return true;
+    }
+
+    void handleEvent(Connection& connection, uint32_t events) {
+        if (!connection.connected && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0) {
+                fail(connection, "connect failed", false);
+                return;
+            }
+            connection.connected = true;
+        }
+        if ((events & EPOLLOUT) && !flush(connection)) {
+            return;
+        }
+        if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            readResponses(connection);
+        }
+    }
+
+    void readResponses(Connection& connection) {
+        char chunk[16384];
+        bool closed = false;
+        for (;;) {
+            ssize_t received = ::recv(connection.fd, chunk, sizeof(chunk), 0);
+            if (received > 0) {
+                connection.in.append(chunk, static_cast<size_t>(received));
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            closed = true;
+            break;
+        }
+
+        // Callbacks run last: they may submit more requests, which can touch
+        // or even close this connection
+        Host& host = *connection.host;
+        std::vector<std::pair<Callback, HttpResponse>> completed;
+        size_t consumed = 0;
+        HttpMessage message;
+        bool malformed = false;
+        while (!connection.awaiting.empty()) {
+            std::string_view rest = std::string_view(connection.in).substr(consumed);
+            size_t size = HttpMessageParser::completeResponseSize(rest, connection.awaiting.front().headRequest,
+                                                                  closed, message);
+            if (size == HttpMessageParser::malformed) {
+                malformed = true;
+                break;
+            }
+            if (size == 0) {
+                break;
+            }
+            consumed += size;
+            int status = HttpMessageParser::statusCode(message.head);
+            if (status < 200) {
+                continue;  // interim response such as 100 Continue; the final one follows
+            }
+            HttpResponse response;
+            response.statusCode = status;
+            if (message.chunked) {
+                response.body = std::move(message.decodedBody);
+            } else {
+                response.body.assign(message.body);
+            }
+            completed.emplace_back(std::move(connection.awaiting.front().callback), std::move(response));
+            connection.awaiting.pop_front();
+            --host.inFlight;
+            --outstanding;
+            if (message.closeConnection) {
+                // No further responses come on this connection; take it out of the pool
+                connection.closing = true;
+                host.connections.erase(std::find(host.connections.begin(), host.connections.end(), &connection));
+                break;
+            }
+        }
+        connection.in.erase(0, consumed);
+
+        if (malformed) {
+            fail(connection, "malformed response from server", false);
+        } else if (closed || connection.closing) {
+            fail(connection, "connection closed by server", true);
+        } else {
+            dispatch(host);
+        }
+        for (auto& [callback, response] : completed) {
+            callback(response);
+        }
+    }
+
+    static bool isIdempotent(const std::string& method) {
+        return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" ||
+               method == "OPTIONS" || method == "TRACE";
+    }
+
+    // Closes the connection and fails everything waiting on it. With retry,
+    // idempotent requests that have not been retried yet go back to the front
+    // of the host's queue once, to be sent on a fresh connection: a pooled
+    // keep-alive connection may have been closed by the server while idle.
+    void fail(Connection& connection, const std::string& reason, bool retry) {
+        Host& host = *connection.host;
+        std::deque<Pending> awaiting = std::move(connection.awaiting);
+        host.inFlight -= awaiting.size();
+        auto pooled = std::find(host.connections.begin(), host.connections.end(), &connection);
+        if (pooled != host.connections.end()) {
+            host.connections.erase(pooled);
+        }
+        int fd = connection.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd);  // destroys connection
+
+        std::vector<Callback> failed;
+        for (auto pending = awaiting.rbegin(); pending != awaiting.rend(); ++pending) {
+            if (retry && pending->retryable && !pending->retried) {
+                pending->retried = true;
+                host.queue.push_front(std::move(*pending));
+            } else {
+                failed.push_back(std::move(pending->callback));
+            }
+        }
+        outstanding -= failed.size();
+        HttpResponse response;
+        response.error = reason;
+        for (auto callback = failed.rbegin(); callback != failed.rend(); ++callback) {
+            (*callback)(response);
+        }
+        dispatch(host);
+    }
+
+    HttpExecutorConfig config;
+    int epollFd = -1;
+    size_t outstanding = 0;
+    std::unordered_map<std::string, std::unique_ptr<Host>> hosts;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+};
+
+// Minimal HTTP/1.1 server on 127.0.0.1 for tests and benchmarks. It accepts
+// keep-alive connections, handles pipelined requests and answers each one
+// with 200 and the number of body bytes it received. With a nonzero
+// requestsPerConnection it answers that many requests on a connection, the
+// last one with "Connection: close", and then closes it.
+class LoopbackHttpServer {
+public:
+    explicit LoopbackHttpServer(size_t requestsPerConnection = 0) : requestsPerConnection(requestsPerConnection) {
+        listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot create loopback socket");
+        }
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listenFd, 128) != 0) {
+            ::close(listenFd);
+            throw std::runtime_error("Cannot listen on loopback");
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        boundPort = ntohs(address.sin_port);
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        watch(listenFd);
+        watch(wakeFd);
+        worker = std::thread([this] { serve(); });
+    }
+
+    ~LoopbackHttpServer() {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        worker.join();
+        for (auto& client : clients) {
+            ::close(client.first);
+        }
+        ::close(listenFd);
+        ::close(wakeFd);
+        ::close(epollFd);
+    }
+
+    LoopbackHttpServer(const LoopbackHttpServer&) = delete;
+    LoopbackHttpServer& operator=(const LoopbackHttpServer&) = delete;
+
+    uint16_t port() const { return boundPort; }
+
+    std::string url(const std::string& path) const {
+        return "http://127.0.0.1:" + std::to_string(boundPort) + path;
+    }
+
+private:
+    void watch(int fd) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    void serve() {
+        std::array<epoll_event, 64> events;
+        for (;;) {
+            int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wakeFd) {
+                    return;
+                }
+                if (fd == listenFd) {
+                    int client;
+                    while ((client = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                        int one = 1;
+                        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                        clients[client];
+                        watch(client);
+                    }
+                    continue;
+                }
+                serveClient(fd);
+            }
+        }
+    }
+
+    void serveClient(int fd) {
+        Client& client = clients[fd];
+        std::string& in = client.in;
+        char chunk[16384];
+        bool closed = false;
+        for (;;) {
+            ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received > 0) {
+                in.append(chunk, static_cast<size_t>(received));
+            } else {
+                closed = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+                break;
+            }
+        }
+
+        std::string out;
+        size_t consumed = 0;
+        HttpMessage message;
+        size_t size;
+        while ((size = HttpMessageParser::completeMessageSize(std::string_view(in).substr(consumed), message)) != 0) {
+            if (size == HttpMessageParser::malformed) {
+                out.append("HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+                closed = true;
+                break;
+            }
+            std::string reply = std::to_string(message.bodyLength);
+            out.append("HTTP/1.1 200 OK\r\nContent-Length: ").append(std::to_string(reply.size()));
+            consumed += size;
+            if (++client.served == requestsPerConnection) {
+                out.append("\r\nConnection: close\r\n\r\n").append(reply);
+                closed = true;
+                break;
+            }
+            out.append("\r\n\r\n").append(reply);
+        }
+        in.erase(0, consumed);
+        sendAll(fd, out);
+
+        if (closed) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+            clients.erase(fd);
+        }
+    }
+
+    // Blocking-style send on a non-blocking socket; replies are small
+    static void sendAll(int fd, const std::string& data) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t written = ::send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    pollfd waitFd{fd, POLLOUT, 0};
+                    ::poll(&waitFd, 1, 100);
+                    continue;
+                }
+                return;
+            }
+            offset += static_cast<size_t>(written);
+        }
+    }
+
+    struct Client {
+        std::string in;  // unparsed input
+        size_t served = 0;
+    };
+
+    size_t requestsPerConnection;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    uint16_t boundPort = 0;
+    std::unordered_map<int, Client> clients;  // by fd
+    std::thread worker;
+};
+
+// Fields tracked by StaticHttpRequestBuilder; a request needs a method and a URL
+namespace HttpRequestField {
+    constexpr uint32_t Method = 1;
+    constexpr uint32_t Url = 2;
+    constexpr uint32_t required = Method | Url;
+}
+
+// Compile-time checked request builder: build() does not compile until the
+// method and URL are set. Headers and body are optional.
+template <uint32_t Set = 0>
+class StaticHttpRequestBuilder : public StaticBuilder<StaticHttpRequestBuilder, HttpRequest, HttpRequestField::required, Set> {
+public:
+    StaticHttpRequestBuilder() = default;
+    explicit StaticHttpRequestBuilder(std::unique_ptr<HttpRequest> partial)
+        : StaticHttpRequestBuilder::StaticBuilder(std::move(partial)) {}
+
+    auto setMethod(std::string method) && {
+        this->product->method = std::move(method);
+        return this->template with<HttpRequestField::Method>();
+    }
+
+    auto setUrl(std::string url) && {
+        this->product->url = std::move(url);
+        return this->template with<HttpRequestField::Url>();
+    }
+
+    auto addHeader(std::string key, std::string value) && {
+        this->product->headers[std::move(key)] = std::move(value);
+        return this->template with<0>();
+    }
+
+    auto setBody(std::string body) && {
+        this->product->body = std::move(body);
+        return this->template with<0>();
+    }
+
+    auto setBodySource(std::shared_ptr<BodySource> source) && {
+        this->product->bodySource = std::move(source);
+        return this->template with<0>();
+    }
+};
+
+static_assert(!CanBuild<decltype(StaticHttpRequestBuilder<>().setMethod("GET"))>,
+              "A request without a URL must not build");
+
 // Example usage
 int main() {
     ConcreteHttpRequestBuilder builder;
@@ -75,5 +1239,196 @@ int main() {
                           .setBody(R"({"key": "value"})")
                           .build();
     request->send();
+
+    // The same request through the compile-time checked builder, against the virtual one
+    const size_t buildCount = 1000000;
+    size_t built = 0;
+    double virtualNs = nanosecondsPerBuild(buildCount, [&](size_t) {
+        ConcreteHttpRequestBuilder virtualBuilder;
+        built += virtualBuilder.setMethod("POST")
+                     .setUrl("http://example.com/api/data")
+                     .addHeader("Content-Type", "application/json")
+                     .setBody(R"({"key": "value"})")
+                     .build()
+                     ->url.size();
+    });
+    double staticNs = nanosecondsPerBuild(buildCount, [&](size_t) {
+        built += StaticHttpRequestBuilder<>()
+                     .setMethod("POST")
+                     .setUrl("http://example.com/api/data")
+                     .addHeader("Content-Type", "application/json")
+                     .setBody(R"({"key": "value"})")
+                     .build()
+                     ->url.size();
+    });
+    std::cout << "Virtual request builder: " << virtualNs << " ns per request, static builder: " << staticNs
+              << " ns (" << built << " URL bytes)" << std::endl;
+
+    // Build many requests with one reused builder
+    BufferedHttpRequestBuilder buffered;
+    std::string id;
+    id.reserve(32);
+    size_t bytes = 0;
+    size_t allocationsBefore = 0;
+    for (int i = 0; i < 100000; ++i) {
+        if (i == 1) {
+            allocationsBefore = allocationCount();  // the first request warms the buffers
+        }
+        id.assign("req-").append(std::to_string(i % 10));
+        buffered.reset();
+        buffered.setMethod(HttpMethod::Post)
+                .setUrl("http://example.com/api/data")
+                .addHeader("Content-Type", "application/json")
+                .addHeader("X-Request-Id", id)
+                .setBody(R"({"key": "value"})");
+        bytes += buffered.getUrl().size() + buffered.getBody().size();
+    }
+    std::cout << "Built 100000 buffered requests (" << bytes << " bytes) with "
+              << allocationCount() - allocationsBefore << " allocations after warm-up" << std::endl;
+    buffered.build()->send();
+
+    // Response framing: bodies that end at the head, an unparsable length,
+    // a chunked body and a body that runs until the connection closes
+    HttpMessage message;
+    const std::string noContent = "HTTP/1.1 204 No Content\r\nContent-Length: 5\r\n\r\n";
+    const std::string headReply = "HTTP/1.1 200 OK\r\nContent-Length: 1024\r\n\r\n";
+    const std::string badLength = "HTTP/1.1 200 OK\r\nContent-Length: 12abc\r\n\r\n";
+    std::cout << "204 response: " << HttpMessageParser::completeResponseSize(noContent, false, false, message)
+              << " of " << noContent.size() << " bytes, HEAD response: "
+              << HttpMessageParser::completeResponseSize(headReply, true, false, message) << " of "
+              << headReply.size() << " bytes, bad Content-Length rejected: " << std::boolalpha
+              << (HttpMessageParser::completeResponseSize(badLength, false, false, message) ==
+                  HttpMessageParser::malformed)
+              << std::noboolalpha << std::endl;
+    const std::string chunkedReply = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nHello\r\n6\r\n, HTTP\r\n0\r\n\r\n";
+    HttpMessageParser::completeResponseSize(chunkedReply, false, false, message);
+    std::cout << "Chunked response body: \"" << message.decodedBody << "\"";
+    const std::string untilClose = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n\r\nstreamed until close";
+    size_t openSize = HttpMessageParser::completeResponseSize(untilClose, false, false, message);
+    HttpMessageParser::completeResponseSize(untilClose, false, true, message);
+    std::cout << ", unframed response: " << openSize << " bytes while open, \"" << message.body
+              << "\" once closed" << std::endl;
+
+    // Execute requests against a local server: sequential versus pipelined
+    LoopbackHttpServer server;
+    auto templateRequest = ConcreteHttpRequestBuilder()
+                               .setMethod("POST")
+                               .setUrl(server.url("/api/data"))
+                               .addHeader("Content-Type", "application/json")
+                               .setBody(R"({"key": "value"})")
+                               .build();
+    // Closed loop: each completed request submits the next one, keeping
+    // `inFlight` requests outstanding
+    const size_t requestCount = 20000;
+    for (auto [connections, inFlight] : {std::pair<size_t, size_t>{1, 1}, std::pair<size_t, size_t>{4, 64}}) {
+        HttpExecutor executor(HttpExecutorConfig{connections, inFlight});
+        std::vector<double> latencies;
+        latencies.reserve(requestCount);
+        size_t submitted = 0;
+        size_t failures = 0;
+        std::function<void()> submitNext = [&] {
+            ++submitted;
+            auto sentAt = std::chrono::steady_clock::now();
+            executor.submit(*templateRequest, [&, sentAt](const HttpResponse& response) {
+                if (response.statusCode != 200) {
+                    ++failures;
+                }
+                latencies.push_back(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - sentAt).count());
+                if (submitted < requestCount) {
+                    submitNext();
+                }
+            });
+        };
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < inFlight; ++i) {
+            submitNext();
+        }
+        executor.run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << connections << " connection(s), " << inFlight << " in flight: "
+                  << requestCount / seconds << " req/s, p50 " << latencies[latencies.size() / 2]
+                  << "us, p99 " << latencies[latencies.size() * 99 / 100] << "us, failures " << failures
+                  << std::endl;
+    }
+
+    // A server that closes every connection after 100 requests: GETs that were
+    // pipelined past the close are sent again on a fresh connection
+    {
+        LoopbackHttpServer closingServer(100);
+        auto get = ConcreteHttpRequestBuilder().setMethod("GET").setUrl(closingServer.url("/api/data")).build();
+        HttpExecutor executor(HttpExecutorConfig{2, 32});
+        size_t succeeded = 0;
+        size_t failed = 0;
+        for (int i = 0; i < 2000; ++i) {
+            executor.submit(*get, [&](const HttpResponse& response) {
+                ++(response.statusCode == 200 ? succeeded : failed);
+            });
+        }
+        executor.run();
+        std::cout << "Against a server closing every 100 requests: " << succeeded << " succeeded, " << failed
+                  << " failed" << std::endl;
+    }
+
+    // Upload large bodies without buffering them: file descriptor, mapped file and generator
+    const std::string uploadPath = (std::filesystem::temp_directory_path() / "rest_api_upload.bin").string();
+    const size_t fileSize = 32 * 1024 * 1024;
+    {
+        std::ofstream file(uploadPath, std::ios::binary | std::ios::trunc);
+        std::string block(1024 * 1024, 'x');
+        for (size_t written = 0; written < fileSize; written += block.size()) {
+            file.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+    }
+    int uploadFd = ::open(uploadPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (uploadFd < 0) {
+        std::cerr << "Cannot open upload file " << uploadPath << ": " << std::strerror(errno) << std::endl;
+        std::remove(uploadPath.c_str());
+        return 1;
+    }
+    const size_t generatedSize = 8 * 1024 * 1024;
+    size_t generated = 0;
+    std::pair<const char*, std::shared_ptr<BodySource>> uploads[] = {
+        {"sendfile", BodySource::fromFileDescriptor(uploadFd, 0, fileSize)},
+        {"mapped file", BodySource::fromMappedFile(uploadPath)},
+        {"generator (chunked)", BodySource::fromGenerator([&generated, generatedSize](char* buffer, size_t capacity) {
+            size_t count = std::min(capacity, generatedSize - generated);
+            std::memset(buffer, 'y', count);
+            generated += count;
+            return count;
+        })},
+    };
+    for (auto& [label, source] : uploads) {
+        auto upload = ConcreteHttpRequestBuilder()
+                          .setMethod("PUT")
+                          .setUrl(server.url("/api/upload"))
+                          .addHeader("Content-Type", "application/octet-stream")
+                          .setBodySource(source)
+                          .build();
+        size_t expected = source->hasKnownLength() ? source->length() : generatedSize;
+        HttpExecutor executor;
+        std::string received;
+        auto start = std::chrono::steady_clock::now();
+        executor.submit(*upload, [&](const HttpResponse& response) {
+            received = response.statusCode == 200 ? response.body : response.error;
+        });
+        executor.run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Uploaded " << expected / (1024 * 1024) << " MB via " << label << ": server received "
+                  << received << " bytes" << (received == std::to_string(expected) ? "" : " (MISMATCH)")
+                  << ", " << expected / seconds / (1024 * 1024) << " MB/s" << std::endl;
+    }
+    // The generator has been drained by its upload; sending it again is refused
+    try {
+        HttpExecutor executor;
+        executor.submit(*ConcreteHttpRequestBuilder().setMethod("PUT").setUrl(server.url("/api/upload"))
+                             .setBodySource(uploads[2].second).build(),
+                        [](const HttpResponse&) {});
+    } catch (const std::logic_error& error) {
+        std::cout << "Resubmitting the generator body: " << error.what() << std::endl;
+    }
+    ::close(uploadFd);
+    std::remove(uploadPath.c_str());
     return 0;
 }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Base for builders that track at compile time which fields have been set.
+// Each field is one bit of Set. A setter stores into the product and returns
+// the builder type with its bit added; build() only exists once every bit of
+// Required is set, so a missing field is a compile error instead of a bad
+// object at runtime. There are no virtual calls, so a chain inlines to
+// stores into the product. The product is held by pointer, like the virtual
+// builders' results, so passing it to the next builder type is a pointer move.
+//
+// Derived is a class template over the mask of fields set so far:
+//
+//   template <uint32_t Set = 0>
+//   class MyBuilder : public StaticBuilder<MyBuilder, MyProduct, requiredFields, Set> {
+//   public:
+//       MyBuilder() = default;
+//       explicit MyBuilder(std::unique_ptr<MyProduct> partial) : MyBuilder::StaticBuilder(std::move(partial)) {}
+//       auto setName(std::string name) && {
+//           this->product->name = std::move(name);
+//           return this->template with<nameField>();
+//       }
+//   };
+//
+// Setters are rvalue-qualified: a chain runs on a temporary, and keeping an
+// intermediate builder takes an explicit std::move.
+template <template <uint32_t> class Derived, typename Product, uint32_t Required, uint32_t Set>
+class StaticBuilder {
+public:
+    static constexpr bool complete = (Set & Required) == Required;
+
+    std::unique_ptr<Product> build() && requires complete {
+        return std::move(product);
+    }
+
+protected:
+    StaticBuilder() : product(new Product()) {}
+    explicit StaticBuilder(std::unique_ptr<Product> partial) : product(std::move(partial)) {}
+
+    // Moves the product into the builder type that also has Field set
+    template <uint32_t Field>
+    Derived<Set | Field> with() {
+        return Derived<Set | Field>(std::move(product));
+    }
+
+    std::unique_ptr<Product> product;
+};
+
+// True if build() can be called on the builder type
+template <typename Builder>
+concept CanBuild = requires(Builder builder) { std::move(builder).build(); };
@@ -2,6 +2,26 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../Common/Benchmark.h"
+#include "StaticBuilder.h"
 
 // Represents a YouTube video, holding all relevant information
 // that would be needed to define and display a video's metadata on YouTube.
@@ -13,7 +33,7 @@ public:
     std::vector<std::string> tags;
     std::string privacyStatus;
     std::string thumbnailUrl;
-    bool monetizationEnabled;
+    bool monetizationEnabled = false;
 
     // Function to display all current video details to the console.
     void displayDetails() const {
@@ -40,6 +60,14 @@ public:
     virtual YouTubeVideoBuilder& addTag(const std::string& tag) = 0;
     virtual YouTubeVideoBuilder& setPrivacyStatus(const std::string& status) = 0;
     virtual YouTubeVideoBuilder& setThumbnailUrl(const std::string& url) = 0;
+
+    // Overloads that move the string into the video instead of copying it.
+    virtual YouTubeVideoBuilder& setTitle(std::string&& title) = 0;
+    virtual YouTubeVideoBuilder& setDescription(std::string&& description) = 0;
+    virtual YouTubeVideoBuilder& addTag(std::string&& tag) = 0;
+    virtual YouTubeVideoBuilder& setPrivacyStatus(std::string&& status) = 0;
+    virtual YouTubeVideoBuilder& setThumbnailUrl(std::string&& url) = 0;
+
     virtual YouTubeVideoBuilder& enableMonetization(bool enabled) = 0;
     virtual std::unique_ptr<YouTubeVideo> build() = 0;
 };
@@ -82,6 +110,31 @@ public:
         return *this;
     }
 
+    YouTubeVideoBuilder& setTitle(std::string&& title) override {
+        video->title = std::move(title);
+        return *this;
+    }
+
+    YouTubeVideoBuilder& setDescription(std::string&& description) override {
+        video->description = std::move(description);
+        return *this;
+    }
+
+    YouTubeVideoBuilder& addTag(std::string&& tag) override {
+        video->tags.push_back(std::move(tag));
+        return *this;
+    }
+
+    YouTubeVideoBuilder& setPrivacyStatus(std::string&& status) override {
+        video->privacyStatus = std::move(status);
+        return *this;
+    }
+
+    YouTubeVideoBuilder& setThumbnailUrl(std::string&& url) override {
+        video->thumbnailUrl = std::move(url);
+        return *this;
+    }
+
     YouTubeVideoBuilder& enableMonetization(bool enabled) override {
         video->monetizationEnabled = enabled;
         return *this;
@@ -92,6 +145,448 @@ public:
     std::unique_ptr<YouTubeVideo> build() override {
         return std::move(video);
     }
+
+    // Moves the finished video into an existing record and starts a new one,
+    // so a single builder can fill a whole store without allocating a
+    // YouTubeVideo per record.
+    void buildInto(YouTubeVideo& record) {
+        record = std::move(*video);
+        *video = YouTubeVideo();
+    }
+};
+
+// Fields tracked by StaticYouTubeVideoBuilder; a video needs a title and a privacy status.
+namespace YouTubeVideoField {
+    constexpr uint32_t Title = 1;
+    constexpr uint32_t PrivacyStatus = 2;
+    constexpr uint32_t required = Title | PrivacyStatus;
+}
+
+// Compile-time checked video builder: build() does not compile until the
+// title and privacy status are set.
+template <uint32_t Set = 0>
+class StaticYouTubeVideoBuilder
+    : public StaticBuilder<StaticYouTubeVideoBuilder, YouTubeVideo, YouTubeVideoField::required, Set> {
+public:
+    StaticYouTubeVideoBuilder() = default;
+    explicit StaticYouTubeVideoBuilder(std::unique_ptr<YouTubeVideo> partial)
+        : StaticYouTubeVideoBuilder::StaticBuilder(std::move(partial)) {}
+
+    auto setTitle(std::string title) && {
+        this->product->title = std::move(title);
+        return this->template with<YouTubeVideoField::Title>();
+    }
+
+    auto setDescription(std::string description) && {
+        this->product->description = std::move(description);
+        return this->template with<0>();
+    }
+
+    auto addTag(std::string tag) && {
+        this->product->tags.push_back(std::move(tag));
+        return this->template with<0>();
+    }
+
+    auto setPrivacyStatus(std::string status) && {
+        this->product->privacyStatus = std::move(status);
+        return this->template with<YouTubeVideoField::PrivacyStatus>();
+    }
+
+    auto setThumbnailUrl(std::string url) && {
+        this->product->thumbnailUrl = std::move(url);
+        return this->template with<0>();
+    }
+
+    auto enableMonetization(bool enabled) && {
+        this->product->monetizationEnabled = enabled;
+        return this->template with<0>();
+    }
+};
+
+static_assert(!CanBuild<decltype(StaticYouTubeVideoBuilder<>().setTitle("Untitled"))>,
+              "A video without a privacy status must not build");
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + path);
+            }
+            ::madvise(mapped, length, MADV_SEQUENTIAL);
+            bytes = static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (bytes != nullptr) {
+            ::munmap(const_cast<char*>(bytes), length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+};
+
+// Result of one ingestion run.
+struct IngestStats {
+    size_t records = 0;
+    size_t malformedLines = 0;
+    double seconds = 0;
+};
+
+// Builds YouTubeVideo records from a line-delimited metadata file on
+// parallel workers. Each line holds six tab-separated fields:
+//   title, description, comma-separated tags, privacy status,
+//   thumbnail URL, monetization (1 or 0)
+// Fields cannot contain tabs or newlines; lines with a different number of
+// fields are skipped and counted.
+//
+// The file is split into one byte range per worker, cut at line ends. A
+// first parallel pass counts the lines of each range, which sizes the store
+// once and gives every worker its own slice of it; the second pass parses
+// into that slice with one reused builder per worker.
+class VideoMetadataIngestor {
+public:
+    explicit VideoMetadataIngestor(unsigned threadCount) : threadCount(std::max(1u, threadCount)) {}
+
+    // Replaces the contents of store with the records of the file.
+    IngestStats ingest(const std::string& path, std::vector<YouTubeVideo>& store) const {
+        auto start = std::chrono::steady_clock::now();
+        MappedFile file(path);
+        std::vector<std::pair<const char*, const char*>> ranges = splitAtLines(file.data(), file.size());
+
+        std::vector<size_t> firstRecord(ranges.size() + 1, 0);
+        runWorkers(ranges.size(), [&](size_t worker) {
+            firstRecord[worker + 1] = countLines(ranges[worker].first, ranges[worker].second);
+        });
+        for (size_t worker = 0; worker < ranges.size(); ++worker) {
+            firstRecord[worker + 1] += firstRecord[worker];
+        }
+        store.clear();
+        store.resize(firstRecord.back());
+
+        std::vector<size_t> parsed(ranges.size(), 0);
+        runWorkers(ranges.size(), [&](size_t worker) {
+            parsed[worker] = parseRange(ranges[worker].first, ranges[worker].second, store.data() + firstRecord[worker]);
+        });
+
+        // Close the gaps that skipped lines left at the end of each slice
+        IngestStats stats;
+        for (size_t worker = 0; worker < ranges.size(); ++worker) {
+            for (size_t i = 0; i < parsed[worker]; ++i) {
+                size_t from = firstRecord[worker] + i;
+                if (stats.records != from) {
+                    store[stats.records] = std::move(store[from]);
+                }
+                ++stats.records;
+            }
+        }
+        store.resize(stats.records);
+        stats.malformedLines = firstRecord.back() - stats.records;
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+private:
+    std::vector<std::pair<const char*, const char*>> splitAtLines(const char* data, size_t size) const {
+        std::vector<std::pair<const char*, const char*>> ranges;
+        const char* end = data + size;
+        const char* begin = data;
+        for (unsigned worker = 0; worker < threadCount && begin < end; ++worker) {
+            const char* cut = worker + 1 == threadCount ? end : begin + (end - begin) / (threadCount - worker);
+            if (cut < end) {
+                const char* newline = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+                cut = newline == nullptr ? end : newline + 1;
+            }
+            ranges.emplace_back(begin, cut);
+            begin = cut;
+        }
+        return ranges;
+    }
+
+    template <typename Work>
+    static void runWorkers(size_t count, Work work) {
+        std::vector<std::thread> workers;
+        for (size_t worker = 1; worker < count; ++worker) {
+            workers.emplace_back(work, worker);
+        }
+        if (count > 0) {
+            work(0);
+        }
+        for (auto& thread : workers) {
+            thread.join();
+        }
+    }
+
+    // Counts lines, including a last line without a newline; empty lines are not records
+    static size_t countLines(const char* begin, const char* end) {
+        size_t lines = 0;
+        while (begin < end) {
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+            const char* lineEnd = newline == nullptr ? end : newline;
+            lines += lineEnd != begin;
+            begin = lineEnd + 1;
+        }
+        return lines;
+    }
+
+    // Parses every line of the range into consecutive records; returns how many were valid
+    static size_t parseRange(const char* begin, const char* end, YouTubeVideo* records) {
+        ConcreteYouTubeVideoBuilder builder;
+        size_t valid = 0;
+        std::string_view fields[6];
+        while (begin < end) {
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+            std::string_view line(begin, (newline == nullptr ? end : newline) - begin);
+            begin = newline == nullptr ? end : newline + 1;
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);  // CRLF line endings
+            }
+            if (line.empty()) {
+                continue;
+            }
+            if (!splitFields(line, fields) || (fields[5] != "0" && fields[5] != "1")) {
+                continue;
+            }
+            builder.setTitle(std::string(fields[0]))
+                   .setDescription(std::string(fields[1]))
+                   .setPrivacyStatus(std::string(fields[3]))
+                   .setThumbnailUrl(std::string(fields[4]))
+                   .enableMonetization(fields[5] == "1");
+            std::string_view tags = fields[2];
+            while (!tags.empty()) {
+                size_t comma = tags.find(',');
+                builder.addTag(std::string(tags.substr(0, comma)));
+                tags = comma == std::string_view::npos ? std::string_view() : tags.substr(comma + 1);
+            }
+            builder.buildInto(records[valid++]);
+        }
+        return valid;
+    }
+
+    static bool splitFields(std::string_view line, std::string_view (&fields)[6]) {
+        size_t field = 0;
+        while (field < 5) {
+            size_t tab = line.find('\t');
+            if (tab == std::string_view::npos) {
+                return false;
+            }
+            fields[field++] = line.substr(0, tab);
+            line.remove_prefix(tab + 1);
+        }
+        fields[5] = line;
+        return line.find('\t') == std::string_view::npos;
+    }
+
+    unsigned threadCount;
+};
+
+// Privacy status of a video; the compact catalog stores it in two bits.
+enum class PrivacyStatus : uint8_t {
+    Public,
+    Unlisted,
+    Private
+};
+
+// Throws std::invalid_argument for anything but the three known statuses.
+PrivacyStatus parsePrivacyStatus(std::string_view status) {
+    if (status == "Public") {
+        return PrivacyStatus::Public;
+    }
+    if (status == "Unlisted") {
+        return PrivacyStatus::Unlisted;
+    }
+    if (status == "Private") {
+        return PrivacyStatus::Private;
+    }
+    throw std::invalid_argument("Unknown privacy status: " + std::string(status));
+}
+
+const char* privacyStatusName(PrivacyStatus status) {
+    switch (status) {
+        case PrivacyStatus::Public: return "Public";
+        case PrivacyStatus::Unlisted: return "Unlisted";
+        case PrivacyStatus::Private: return "Private";
+    }
+    return "Unknown";
+}
+
+// Memory used by a video catalog, in bytes, not counting allocator overhead.
+struct CatalogMemoryReport {
+    size_t records = 0;
+    size_t strings = 0;
+    size_t tags = 0;
+    size_t total() const { return records + strings + tags; }
+};
+
+// Estimates the memory a vector of YouTubeVideo objects uses, for comparison.
+CatalogMemoryReport measureVideos(const std::vector<YouTubeVideo>& videos) {
+    auto heapBytes = [](const std::string& text) {
+        return text.capacity() > 15 ? text.capacity() + 1 : 0;  // libstdc++ keeps 15 chars inline
+    };
+    CatalogMemoryReport report;
+    report.records = videos.capacity() * sizeof(YouTubeVideo);
+    for (const auto& video : videos) {
+        report.strings += heapBytes(video.title) + heapBytes(video.description) +
+                          heapBytes(video.privacyStatus) + heapBytes(video.thumbnailUrl);
+        report.tags += video.tags.capacity() * sizeof(std::string);
+        for (const auto& tag : video.tags) {
+            report.tags += heapBytes(tag);
+        }
+    }
+    return report;
+}
+
+// Catalog of videos in a compact layout: a fixed 32-byte record per video,
+// all text in one shared arena, and tags as ids into a shared dictionary,
+// stored for every video in one flat array.
+class CompactVideoCatalog {
+public:
+    size_t size() const { return records.size(); }
+
+    void reserve(size_t videoCount, size_t arenaBytes) {
+        records.reserve(videoCount);
+        arena.reserve(arenaBytes);
+    }
+
+    // Throws std::invalid_argument for an unknown privacy status and
+    // std::length_error if the video does not fit; a rejected video leaves
+    // the catalog unchanged.
+    size_t add(const YouTubeVideo& video) {
+        Record record;
+        record.flags = static_cast<uint8_t>(parsePrivacyStatus(video.privacyStatus)) |
+                       (video.monetizationEnabled ? monetizationFlag : 0);
+        if (video.tags.size() > UINT16_MAX) {
+            throw std::length_error("Too many tags on one video");
+        }
+        if (video.tags.size() > UINT32_MAX - tagIds.size()) {
+            throw std::length_error("Catalog tag list is full");
+        }
+        size_t textBytes = video.title.size() + video.description.size() + video.thumbnailUrl.size();
+        if (textBytes > UINT32_MAX - arena.size()) {
+            throw std::length_error("Catalog string arena is full");
+        }
+        record.title = store(video.title);
+        record.description = store(video.description);
+        record.thumbnailUrl = store(video.thumbnailUrl);
+        record.firstTag = static_cast<uint32_t>(tagIds.size());
+        record.tagCount = static_cast<uint16_t>(video.tags.size());
+        for (const auto& tag : video.tags) {
+            tagIds.push_back(internTag(tag));
+        }
+        records.push_back(record);
+        return records.size() - 1;
+    }
+
+    std::string_view title(size_t index) const { return text(records[index].title); }
+    std::string_view description(size_t index) const { return text(records[index].description); }
+    std::string_view thumbnailUrl(size_t index) const { return text(records[index].thumbnailUrl); }
+    bool monetizationEnabled(size_t index) const { return records[index].flags & monetizationFlag; }
+
+    PrivacyStatus privacyStatus(size_t index) const {
+        return static_cast<PrivacyStatus>(records[index].flags & privacyMask);
+    }
+
+    // Rebuilds the full YouTubeVideo.
+    YouTubeVideo toVideo(size_t index) const {
+        const Record& record = records[index];
+        ConcreteYouTubeVideoBuilder builder;
+        builder.setTitle(std::string(text(record.title)))
+               .setDescription(std::string(text(record.description)))
+               .setPrivacyStatus(privacyStatusName(privacyStatus(index)))
+               .setThumbnailUrl(std::string(text(record.thumbnailUrl)))
+               .enableMonetization(monetizationEnabled(index));
+        for (uint32_t i = 0; i < record.tagCount; ++i) {
+            builder.addTag(tagNames[tagIds[record.firstTag + i]]);
+        }
+        YouTubeVideo video;
+        builder.buildInto(video);
+        return video;
+    }
+
+    CatalogMemoryReport memoryReport() const {
+        CatalogMemoryReport report;
+        report.records = records.capacity() * sizeof(Record);
+        report.strings = arena.capacity();
+        report.tags = tagIds.capacity() * sizeof(uint32_t);
+        for (const auto& name : tagNames) {
+            report.tags += sizeof(std::string) + name.capacity() + 1;
+        }
+        report.tags += tagLookup.size() * (sizeof(std::string_view) + sizeof(uint32_t) + sizeof(void*));
+        return report;
+    }
+
+private:
+    struct TextRef {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    // Bits 0-1: PrivacyStatus, bit 2: monetization.
+    static constexpr uint8_t privacyMask = 0x3;
+    static constexpr uint8_t monetizationFlag = 0x4;
+
+    struct Record {
+        TextRef title;
+        TextRef description;
+        TextRef thumbnailUrl;
+        uint32_t firstTag = 0;
+        uint16_t tagCount = 0;
+        uint8_t flags = 0;
+    };
+    static_assert(sizeof(Record) == 32, "Record should stay at 32 bytes");
+
+    TextRef store(const std::string& value) {
+        if (arena.size() + value.size() > UINT32_MAX) {
+            throw std::length_error("Catalog string arena is full");
+        }
+        TextRef ref{static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(value.size())};
+        arena.insert(arena.end(), value.begin(), value.end());
+        return ref;
+    }
+
+    std::string_view text(TextRef ref) const {
+        return std::string_view(arena.data() + ref.offset, ref.length);
+    }
+
+    uint32_t internTag(const std::string& tag) {
+        auto it = tagLookup.find(tag);
+        if (it != tagLookup.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(tagNames.size());
+        tagNames.push_back(tag);
+        tagLookup.emplace(tagNames.back(), id);  // the deque keeps the viewed string in place
+        return id;
+    }
+
+    std::vector<Record> records;
+    std::vector<char> arena;
+    std::vector<uint32_t> tagIds;
+    std::deque<std::string> tagNames;
+    std::unordered_map<std::string_view, uint32_t> tagLookup;
 };
 
 // Example usage of the builder to create a YouTube video object.
@@ -107,5 +602,95 @@ int main() {
                         .enableMonetization(true)
                         .build();
     video->displayDetails();  // Output the video details to the console
+
+    // The same video through the compile-time checked builder, against the virtual one
+    const size_t buildCount = 1000000;
+    size_t tagCount = 0;
+    double virtualNs = nanosecondsPerBuild(buildCount, [&](size_t) {
+        ConcreteYouTubeVideoBuilder virtualBuilder;
+        tagCount += virtualBuilder.setTitle("How to Use the Builder Pattern")
+                        .setDescription("A detailed guide on using the Builder Pattern in C++.")
+                        .addTag("Programming")
+                        .addTag("C++")
+                        .setPrivacyStatus("Public")
+                        .enableMonetization(true)
+                        .build()
+                        ->tags.size();
+    });
+    double staticNs = nanosecondsPerBuild(buildCount, [&](size_t) {
+        tagCount += StaticYouTubeVideoBuilder<>()
+                        .setTitle("How to Use the Builder Pattern")
+                        .setDescription("A detailed guide on using the Builder Pattern in C++.")
+                        .addTag("Programming")
+                        .addTag("C++")
+                        .setPrivacyStatus("Public")
+                        .enableMonetization(true)
+                        .build()
+                        ->tags.size();
+    });
+    std::cout << "Virtual video builder: " << virtualNs << " ns per video, static builder: " << staticNs
+              << " ns (" << tagCount << " tags)" << std::endl;
+
+    // Write a bulk metadata file, then ingest it on increasing worker counts.
+    // Odd lines end in CRLF, as if appended by a Windows tool.
+    const std::string metadataPath = (std::filesystem::temp_directory_path() / "youtube_metadata.tsv").string();
+    const size_t lineCount = 1000000;
+    {
+        std::ofstream file(metadataPath, std::ios::trunc);
+        const char* privacy[] = {"Public", "Unlisted", "Private"};
+        for (size_t i = 0; i < lineCount; ++i) {
+            file << "Video number " << i << " about design patterns\t"
+                 << "An in-depth walkthrough of pattern " << i % 23 << " with worked examples\t"
+                 << "Programming,C++,Pattern" << i % 23 << "\t" << privacy[i % 3] << "\t"
+                 << "http://example.com/thumbnails/" << i << ".jpg\t" << i % 2 << (i % 2 ? "\r\n" : "\n");
+        }
+        file << "a malformed line without fields\n";
+    }
+    std::vector<unsigned> threadCounts = {1, 2, 4};
+    if (std::thread::hardware_concurrency() > 4) {
+        threadCounts.push_back(std::thread::hardware_concurrency());
+    }
+    std::vector<YouTubeVideo> store;
+    for (unsigned threads : threadCounts) {
+        IngestStats stats = VideoMetadataIngestor(threads).ingest(metadataPath, store);
+        std::cout << "Ingested " << stats.records << " videos (" << stats.malformedLines << " malformed) on "
+                  << threads << " worker(s): " << static_cast<size_t>(stats.records / stats.seconds)
+                  << " records/s" << std::endl;
+    }
+    size_t monetized = std::count_if(store.begin(), store.end(),
+                                     [](const YouTubeVideo& video) { return video.monetizationEnabled; });
+    std::cout << monetized << " of " << store.size() << " videos monetized" << std::endl;
+    store.back().displayDetails();
+
+    // Pack the ingested videos into the compact catalog and compare memory use
+    CompactVideoCatalog catalog;
+    size_t textBytes = 0;
+    for (const auto& ingested : store) {
+        textBytes += ingested.title.size() + ingested.description.size() + ingested.thumbnailUrl.size();
+    }
+    catalog.reserve(store.size(), textBytes);
+    for (const auto& ingested : store) {
+        catalog.add(ingested);
+    }
+    auto printReport = [](const char* label, const CatalogMemoryReport& report, size_t count) {
+        std::cout << label << ": " << report.total() / count << " bytes per video (records "
+                  << report.records / count << ", strings " << report.strings / count << ", tags "
+                  << report.tags / count << ")" << std::endl;
+    };
+    printReport("YouTubeVideo objects", measureVideos(store), store.size());
+    printReport("Compact catalog     ", catalog.memoryReport(), catalog.size());
+
+    size_t roundTripMismatches = 0;
+    for (size_t i = 0; i < store.size(); ++i) {
+        YouTubeVideo copy = catalog.toVideo(i);
+        const YouTubeVideo& original = store[i];
+        roundTripMismatches += copy.title != original.title || copy.description != original.description ||
+                               copy.tags != original.tags || copy.privacyStatus != original.privacyStatus ||
+                               copy.thumbnailUrl != original.thumbnailUrl ||
+                               copy.monetizationEnabled != original.monetizationEnabled;
+    }
+    std::cout << "Round trip of " << catalog.size() << " videos: " << roundTripMismatches << " mismatches"
+              << std::endl;
+    std::remove(metadataPath.c_str());
     return 0;
 }
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations made through the global operator new, so a demo can
+// show how many allocations and bytes a code path costs: read the counters
+// before and after it and subtract.
+//
+// This header replaces the global operator new and delete, so include it in
+// exactly one translation unit of a program (each demo is a single file).
+// The counters are atomic with relaxed ordering: other threads may allocate
+// at the same time, and their allocations are counted too.
+
+namespace allocation_counter {
+inline std::atomic<size_t> allocations{0};
+inline std::atomic<size_t> bytes{0};
+}
+
+// Allocations made through operator new since the program started
+inline size_t allocationCount() {
+    return allocation_counter::allocations.load(std::memory_order_relaxed);
+}
+
+// Bytes requested through operator new since the program started; frees are not subtracted
+inline size_t allocatedBytes() {
+    return allocation_counter::bytes.load(std::memory_order_relaxed);
+}
+
+// The replacements are kept out of line. If GCC inlines them, it sees malloc()
+// and free() paired with new and delete expressions and reports a false
+// -Wmismatched-new-delete.
+[[gnu::noinline]] void* operator new(size_t size) {
+    allocation_counter::allocations.fetch_add(1, std::memory_order_relaxed);
+    allocation_counter::bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// Average nanoseconds per call of build(i) over count calls, for comparing
+// builder implementations
+template <typename Build>
+double nanosecondsPerBuild(size_t count, Build build) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        build(i);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
@@ -1,56 +1,126 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
-// Base message class
+#include "../Common/AllocationCounter.h"
+
+// Base message class. The type tag lets services check and downcast a
+// message without RTTI.
 class Message {
 public:
+    enum Type {
+        EMAIL,
+        SMS,
+        PUSH_NOTIFICATION
+    };
+
+    explicit Message(Type type) : messageType(type) {}
     virtual ~Message() {}
+
+    Type type() const { return messageType; }
+
+    // Address the message is delivered to, used to coalesce per recipient
+    virtual const std::string& recipient() const = 0;
+
+private:
+    Type messageType;
 };
 
+// Checked downcast using the type tag; throws on a mismatch like the
+// reference dynamic_cast it replaces
+template <typename MessageT>
+const MessageT& messageCast(const Message& message) {
+    if (message.type() != MessageT::staticType) {
+        throw std::invalid_argument("Message type does not match service");
+    }
+    return static_cast<const MessageT&>(message);
+}
+
 // Email message subclass
 class EmailMessage : public Message {
 public:
+    static constexpr Type staticType = EMAIL;
+
     std::string recipientEmail;
     std::string subject;
     std::string body;
 
     EmailMessage(const std::string& recipientEmail, const std::string& subject, const std::string& body)
-        : recipientEmail(recipientEmail), subject(subject), body(body) {}
+        : Message(EMAIL), recipientEmail(recipientEmail), subject(subject), body(body) {}
+
+    const std::string& recipient() const override { return recipientEmail; }
 };
 
 // SMS message subclass
 class SMSMessage : public Message {
 public:
+    static constexpr Type staticType = SMS;
+
     std::string phoneNumber;
     std::string content;
 
     SMSMessage(const std::string& phoneNumber, const std::string& content)
-        : phoneNumber(phoneNumber), content(content) {}
+        : Message(SMS), phoneNumber(phoneNumber), content(content) {}
+
+    const std::string& recipient() const override { return phoneNumber; }
 };
 
 // Push notification message subclass
 class PushNotificationMessage : public Message {
 public:
+    static constexpr Type staticType = PUSH_NOTIFICATION;
+
     std::string deviceToken;
     std::string message;
 
     PushNotificationMessage(const std::string& deviceToken, const std::string& message)
-        : deviceToken(deviceToken), message(message) {}
+        : Message(PUSH_NOTIFICATION), deviceToken(deviceToken), message(message) {}
+
+    const std::string& recipient() const override { return deviceToken; }
 };
 
 // Communication service interface
 class CommunicationService {
 public:
     virtual void sendMessage(const Message& message) = 0;
+    // Sends a drained batch; services with a bulk API can override this
+    virtual void sendBatch(const std::vector<const Message*>& messages) {
+        for (const Message* message : messages) {
+            sendMessage(*message);
+        }
+    }
     virtual ~CommunicationService() {}
 };
 
-// Email service implementation
-class EmailService : public CommunicationService {
+// Typed service interface: send() takes the concrete message type, and the
+// generic sendMessage() only checks the tag before forwarding
+template <typename MessageT>
+class TypedCommunicationService : public CommunicationService {
 public:
+    virtual void send(const MessageT& message) = 0;
+
     void sendMessage(const Message& message) override {
-        const EmailMessage& emailMessage = dynamic_cast<const EmailMessage&>(message);
+        send(messageCast<MessageT>(message));
+    }
+};
+
+// Email service implementation
+class EmailService final : public TypedCommunicationService<EmailMessage> {
+public:
+    void send(const EmailMessage& emailMessage) override {
         std::cout << "Emailing to " << emailMessage.recipientEmail
                   << " with subject '" << emailMessage.subject
                   << "': " << emailMessage.body << std::endl;
@@ -58,25 +128,462 @@ public:
 };
 
 // SMS service implementation
-class SMSService : public CommunicationService {
+class SMSService final : public TypedCommunicationService<SMSMessage> {
 public:
-    void sendMessage(const Message& message) override {
-        const SMSMessage& smsMessage = dynamic_cast<const SMSMessage&>(message);
+    void send(const SMSMessage& smsMessage) override {
         std::cout << "Sending SMS to " << smsMessage.phoneNumber
                   << ": " << smsMessage.content << std::endl;
     }
 };
 
 // Push notification service implementation
-class PushNotificationService : public CommunicationService {
+class PushNotificationService final : public TypedCommunicationService<PushNotificationMessage> {
 public:
-    void sendMessage(const Message& message) override {
-        const PushNotificationMessage& pushMessage = dynamic_cast<const PushNotificationMessage&>(message);
+    void send(const PushNotificationMessage& pushMessage) override {
         std::cout << "Sending Push Notification to " << pushMessage.deviceToken
                   << ": " << pushMessage.message << std::endl;
     }
 };
 
+// Routes mixed messages to the matching typed sender by switching on the
+// message tag. Senders are held by concrete type, so send() calls are direct.
+template <typename EmailSender = EmailService,
+          typename SMSSender = SMSService,
+          typename PushSender = PushNotificationService>
+class MessageRouter {
+public:
+    EmailSender emailSender;
+    SMSSender smsSender;
+    PushSender pushSender;
+
+    void route(const Message& message) {
+        switch (message.type()) {
+            case Message::EMAIL:
+                emailSender.send(static_cast<const EmailMessage&>(message));
+                break;
+            case Message::SMS:
+                smsSender.send(static_cast<const SMSMessage&>(message));
+                break;
+            case Message::PUSH_NOTIFICATION:
+                pushSender.send(static_cast<const PushNotificationMessage&>(message));
+                break;
+        }
+    }
+};
+
+// Sink that only counts payload bytes, used to benchmark dispatch overhead
+template <typename MessageT>
+class CountingSender {
+public:
+    size_t bytes = 0;
+
+    void send(const MessageT& message) {
+        bytes += message.recipient().size();
+    }
+};
+
+// Message body with positional placeholders such as "Hi {0}, your code is {1}".
+// The text is split once into literals so rendering is a plain concatenation.
+class MessageTemplate {
+private:
+    std::vector<std::string> literals;  // always slots.size() + 1 entries
+    std::vector<size_t> slots;
+    size_t slotCount = 0;
+
+public:
+    explicit MessageTemplate(const std::string& text) {
+        std::string literal;
+        for (size_t i = 0; i < text.size(); ++i) {
+            size_t close = text.find('}', i);
+            if (text[i] == '{' && close != std::string::npos && close > i + 1 &&
+                text.find_first_not_of("0123456789", i + 1) == close) {
+                size_t slot = std::stoul(text.substr(i + 1, close - i - 1));
+                literals.push_back(std::move(literal));
+                literal.clear();
+                slots.push_back(slot);
+                slotCount = std::max(slotCount, slot + 1);
+                i = close;
+            } else {
+                literal += text[i];
+            }
+        }
+        literals.push_back(std::move(literal));
+    }
+
+    size_t tokenCount() const { return slotCount; }
+
+    // tokenAt(slot) returns the text substituted for placeholder {slot}
+    template <typename TokenAt>
+    void render(TokenAt tokenAt, std::string& out) const {
+        out.assign(literals[0]);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            out.append(tokenAt(slots[i]));
+            out.append(literals[i + 1]);
+        }
+    }
+};
+
+// Bulk campaign of one message type sharing a body template. Recipients and
+// substitution tokens are appended to one text buffer and referenced by
+// 32-bit offset and length; full messages are only materialized, one at a
+// time, when sending. Tokens registered with intern() are stored once.
+class BulkMessageBatch {
+private:
+    struct TextRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct TextHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>()(text); }
+    };
+
+    Message::Type type;
+    std::string subject;
+    MessageTemplate body;
+    std::string text;
+    std::vector<TextRef> recipients;
+    std::vector<TextRef> tokens;  // body.tokenCount() per recipient
+    std::unordered_map<std::string, TextRef, TextHash, std::equal_to<>> interned;
+
+    TextRef store(std::string_view value) {
+        if (text.size() + value.size() > UINT32_MAX) {
+            throw std::length_error("Bulk batch text exceeds 4 GB");
+        }
+        TextRef ref{static_cast<uint32_t>(text.size()), static_cast<uint32_t>(value.size())};
+        text.append(value);
+        return ref;
+    }
+
+    std::string_view view(TextRef ref) const {
+        return std::string_view(text.data() + ref.offset, ref.length);
+    }
+
+public:
+    // The subject is only used for email campaigns
+    BulkMessageBatch(Message::Type type, const std::string& bodyTemplate, const std::string& subject = "")
+        : type(type), subject(subject), body(bodyTemplate) {}
+
+    // textBytesPerRecipient estimates the recipient and token text of one message
+    void reserve(size_t recipientCount, size_t textBytesPerRecipient = 0) {
+        recipients.reserve(recipientCount);
+        tokens.reserve(recipientCount * body.tokenCount());
+        text.reserve(recipientCount * textBytesPerRecipient);
+    }
+
+    // Stores a token that many recipients share, such as a product name;
+    // add() then references it instead of copying it again
+    void intern(std::string_view token) {
+        if (interned.find(token) == interned.end()) {
+            interned.emplace(std::string(token), store(token));
+        }
+    }
+
+    void add(std::string_view recipient, std::initializer_list<std::string_view> substitutions) {
+        if (substitutions.size() != body.tokenCount()) {
+            throw std::invalid_argument("Wrong number of template substitutions");
+        }
+        recipients.push_back(store(recipient));
+        for (std::string_view token : substitutions) {
+            auto it = interned.empty() ? interned.end() : interned.find(token);
+            tokens.push_back(it != interned.end() ? it->second : store(token));
+        }
+    }
+
+    size_t size() const { return recipients.size(); }
+
+    // Renders the body for one recipient into a caller-owned buffer
+    void renderBody(size_t index, std::string& out) const {
+        const TextRef* first = tokens.data() + index * body.tokenCount();
+        body.render([this, first](size_t slot) { return view(first[slot]); }, out);
+    }
+
+    // Sends every message through the service, reusing one message object
+    void sendTo(CommunicationService& service) const {
+        switch (type) {
+            case Message::EMAIL: {
+                EmailMessage message("", subject, "");
+                sendEach(service, message, message.recipientEmail, message.body);
+                break;
+            }
+            case Message::SMS: {
+                SMSMessage message("", "");
+                sendEach(service, message, message.phoneNumber, message.content);
+                break;
+            }
+            case Message::PUSH_NOTIFICATION: {
+                PushNotificationMessage message("", "");
+                sendEach(service, message, message.deviceToken, message.message);
+                break;
+            }
+        }
+    }
+
+private:
+    void sendEach(CommunicationService& service, const Message& message,
+                  std::string& recipientField, std::string& bodyField) const {
+        for (size_t i = 0; i < recipients.size(); ++i) {
+            recipientField.assign(view(recipients[i]));
+            renderBody(i, bodyField);
+            service.sendMessage(message);
+        }
+    }
+};
+
+// Local stand-in sink that simulates the latency of a remote provider.
+// Each batch costs one round trip, so throughput benchmarks show the effect
+// of batching without talking to a real gateway.
+class SimulatedLatencyService : public CommunicationService {
+private:
+    std::chrono::microseconds latencyPerBatch;
+    std::atomic<size_t> delivered{0};
+
+public:
+    explicit SimulatedLatencyService(std::chrono::microseconds latencyPerBatch)
+        : latencyPerBatch(latencyPerBatch) {}
+
+    void sendMessage(const Message&) override {
+        std::this_thread::sleep_for(latencyPerBatch);
+        delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void sendBatch(const std::vector<const Message*>& messages) override {
+        std::this_thread::sleep_for(latencyPerBatch);
+        delivered.fetch_add(messages.size(), std::memory_order_relaxed);
+    }
+
+    size_t deliveredCount() const { return delivered.load(std::memory_order_relaxed); }
+};
+
+// Bounded lock-free multi-producer queue (sequence-numbered ring buffer).
+// Producers claim a slot with a CAS on the tail; the single channel worker
+// consumes from the head.
+class MessageQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        std::unique_ptr<Message> message;
+    };
+
+    std::vector<Cell> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<size_t> head{0};
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit MessageQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        cells = std::vector<Cell>(size);
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask = size - 1;
+    }
+
+    // Returns false and leaves the message untouched when the queue is full
+    bool push(std::unique_ptr<Message>& message) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == pos) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.message = std::move(message);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < pos) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::unique_ptr<Message> pop() {
+        size_t pos = head.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return nullptr;
+        }
+        head.store(pos + 1, std::memory_order_relaxed);
+        std::unique_ptr<Message> message = std::move(cell.message);
+        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+        return message;
+    }
+};
+
+// Per-channel dispatch settings
+struct ChannelConfig {
+    size_t queueCapacity = 4096;
+    size_t batchSize = 64;
+    double messagesPerSecond = 0;      // 0 disables rate limiting
+    bool coalesceByRecipient = false;  // keep only the latest message per recipient in a batch
+};
+
+// Asynchronous dispatcher: messages are queued per channel and drained by one
+// worker thread per channel, which sends them to the channel's service in batches.
+class MessageDispatcher {
+private:
+    struct Channel {
+        std::unique_ptr<CommunicationService> service;
+        ChannelConfig config;
+        MessageQueue queue;
+        std::thread worker;
+        std::atomic<size_t> sent{0};
+        std::atomic<size_t> coalesced{0};
+
+        Channel(std::unique_ptr<CommunicationService> service, const ChannelConfig& config)
+            : service(std::move(service)), config(config), queue(config.queueCapacity) {}
+    };
+
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::atomic<bool> stopping{false};       // no new submits are accepted
+    std::atomic<bool> closed{false};         // no submit is in flight; workers drain and exit
+    std::atomic<size_t> activeProducers{0};  // submits between their stopping check and push
+
+    static void coalesce(std::vector<std::unique_ptr<Message>>& batch, Channel& channel) {
+        std::unordered_map<std::string, size_t> latest;
+        latest.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            latest[batch[i]->recipient()] = i;
+        }
+        if (latest.size() == batch.size()) {
+            return;
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (latest[batch[i]->recipient()] == i) {
+                batch[kept++] = std::move(batch[i]);
+            }
+        }
+        channel.coalesced.fetch_add(batch.size() - kept, std::memory_order_relaxed);
+        batch.resize(kept);
+    }
+
+    void run(Channel& channel) {
+        using Clock = std::chrono::steady_clock;
+        const ChannelConfig& config = channel.config;
+        std::vector<std::unique_ptr<Message>> batch;
+        std::vector<const Message*> view;
+        batch.reserve(config.batchSize);
+        view.reserve(config.batchSize);
+
+        // Token bucket allowing at most one batch worth of burst
+        double tokens = static_cast<double>(config.batchSize);
+        Clock::time_point lastRefill = Clock::now();
+
+        for (;;) {
+            // Read before popping: once closed, every message is already in the queue
+            bool finalDrain = closed.load(std::memory_order_acquire);
+            size_t budget = config.batchSize;
+            if (config.messagesPerSecond > 0) {
+                Clock::time_point now = Clock::now();
+                tokens += std::chrono::duration<double>(now - lastRefill).count() * config.messagesPerSecond;
+                tokens = std::min(tokens, static_cast<double>(config.batchSize));
+                lastRefill = now;
+                budget = std::min(budget, static_cast<size_t>(tokens));
+                if (budget == 0) {
+                    std::this_thread::sleep_for(std::chrono::duration<double>(1.0 / config.messagesPerSecond));
+                    continue;
+                }
+            }
+
+            while (batch.size() < budget) {
+                std::unique_ptr<Message> message = channel.queue.pop();
+                if (!message) {
+                    break;
+                }
+                batch.push_back(std::move(message));
+            }
+
+            if (batch.empty()) {
+                if (finalDrain) {
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+
+            if (config.messagesPerSecond > 0) {
+                tokens -= static_cast<double>(batch.size());
+            }
+            if (config.coalesceByRecipient) {
+                coalesce(batch, channel);
+            }
+            for (const auto& message : batch) {
+                view.push_back(message.get());
+            }
+            channel.service->sendBatch(view);
+            channel.sent.fetch_add(view.size(), std::memory_order_relaxed);
+            view.clear();
+            batch.clear();
+        }
+    }
+
+public:
+    MessageDispatcher() = default;
+    MessageDispatcher(const MessageDispatcher&) = delete;
+    MessageDispatcher& operator=(const MessageDispatcher&) = delete;
+
+    ~MessageDispatcher() {
+        shutdown();
+    }
+
+    // Registers a channel and starts its worker; returns the channel id
+    size_t addChannel(std::unique_ptr<CommunicationService> service, const ChannelConfig& config = ChannelConfig()) {
+        channels.push_back(std::make_unique<Channel>(std::move(service), config));
+        Channel& channel = *channels.back();
+        channel.worker = std::thread([this, &channel] { run(channel); });
+        return channels.size() - 1;
+    }
+
+    // Queues a message and returns null. If the channel's queue is full the
+    // message is handed back, so the caller can retry or drop it.
+    [[nodiscard]] std::unique_ptr<Message> submit(size_t channelId, std::unique_ptr<Message> message) {
+        Channel& channel = *channels.at(channelId);
+        // Registering before the check lets shutdown() wait for this push
+        activeProducers.fetch_add(1);
+        if (stopping.load()) {
+            activeProducers.fetch_sub(1, std::memory_order_release);
+            throw std::logic_error("Dispatcher is shut down");
+        }
+        channel.queue.push(message);
+        activeProducers.fetch_sub(1, std::memory_order_release);
+        return message;
+    }
+
+    // Rejects new messages, waits for submits in progress, then drains all
+    // queued messages and stops the workers
+    void shutdown() {
+        if (stopping.exchange(true)) {
+            return;
+        }
+        while (activeProducers.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+        closed.store(true, std::memory_order_release);
+        for (auto& channel : channels) {
+            if (channel->worker.joinable()) {
+                channel->worker.join();
+            }
+        }
+    }
+
+    size_t sentCount(size_t channelId) const {
+        return channels.at(channelId)->sent.load(std::memory_order_relaxed);
+    }
+
+    size_t coalescedCount(size_t channelId) const {
+        return channels.at(channelId)->coalesced.load(std::memory_order_relaxed);
+    }
+};
+
 // Factory for creating communication services
 class CommunicationFactory {
 public:
@@ -98,6 +605,16 @@ public:
                 throw std::invalid_argument("Unsupported service type");
         }
     }
+
+    // Creates a dispatcher with one queued channel per service type,
+    // registered so that the channel id equals the ServiceType value
+    static std::unique_ptr<MessageDispatcher> createDispatcher(const ChannelConfig& config = ChannelConfig()) {
+        auto dispatcher = std::make_unique<MessageDispatcher>();
+        for (ServiceType type : {EMAIL, SMS, PUSH_NOTIFICATION}) {
+            dispatcher->addChannel(std::unique_ptr<CommunicationService>(getCommunicationService(type)), config);
+        }
+        return dispatcher;
+    }
 };
 
 // Main function demonstrating usage of the communication services
@@ -122,5 +639,134 @@ int main() {
     delete smsService;
     delete pushService;
 
+    // Queue messages for asynchronous delivery through the dispatcher
+    {
+        ChannelConfig config;
+        config.coalesceByRecipient = true;
+        auto dispatcher = CommunicationFactory::createDispatcher(config);
+        std::pair<CommunicationFactory::ServiceType, std::unique_ptr<Message>> orderUpdates[] = {
+            {CommunicationFactory::EMAIL, std::make_unique<EmailMessage>("user@example.com", "Receipt", "Thanks for your order")},
+            {CommunicationFactory::SMS, std::make_unique<SMSMessage>("1234567890", "Your order has shipped")},
+            {CommunicationFactory::PUSH_NOTIFICATION, std::make_unique<PushNotificationMessage>("device_token_here", "Order update")},
+        };
+        for (auto& [channel, message] : orderUpdates) {
+            // A full queue hands the message back; wait for the worker to make room
+            while ((message = dispatcher->submit(channel, std::move(message)))) {
+                std::this_thread::yield();
+            }
+        }
+        dispatcher->shutdown();
+    }
+
+    // Bulk campaign: shared template, recipients and tokens in one text buffer
+    {
+        BulkMessageBatch campaign(Message::SMS, "Hi {0}, your code is {1}");
+        campaign.add("5550001", {"Alice", "4821"});
+        campaign.add("5550002", {"Bob", "1937"});
+        SMSService service;
+        campaign.sendTo(service);
+
+        // Heap bytes measured by the allocation counter; the names are
+        // formatted into stack buffers so only stored data is counted
+        const size_t recipientCount = 200000;
+        size_t heapBefore = allocatedBytes();
+        BulkMessageBatch bigCampaign(Message::EMAIL, "Hello {0}, {1} is on sale today!", "Weekly deals");
+        bigCampaign.reserve(recipientCount, 32);
+        bigCampaign.intern("Laptop");
+        char name[32];
+        char address[48];
+        for (size_t i = 0; i < recipientCount; ++i) {
+            std::snprintf(name, sizeof(name), "user%zu", i);
+            std::snprintf(address, sizeof(address), "%s@example.com", name);
+            bigCampaign.add(address, {name, "Laptop"});
+        }
+        size_t batchBytes = allocatedBytes() - heapBefore;
+
+        std::string rendered;
+        rendered.reserve(64);
+        heapBefore = allocatedBytes();
+        std::vector<std::unique_ptr<EmailMessage>> materialized;
+        materialized.reserve(recipientCount);
+        for (size_t i = 0; i < recipientCount; ++i) {
+            std::snprintf(address, sizeof(address), "user%zu@example.com", i);
+            bigCampaign.renderBody(i, rendered);
+            auto email = std::make_unique<EmailMessage>("", "Weekly deals", "");
+            email->recipientEmail.assign(address);
+            email->body.assign(rendered);
+            materialized.push_back(std::move(email));
+        }
+        size_t materializedBytes = allocatedBytes() - heapBefore;
+        std::cout << "Bulk batch: " << static_cast<double>(batchBytes) / recipientCount
+                  << " heap bytes per message, vs " << static_cast<double>(materializedBytes) / recipientCount
+                  << " for EmailMessage objects" << std::endl;
+    }
+
+    // Dispatch overhead: dynamic_cast lookup versus tag-based routing
+    {
+        const size_t benchmarkCount = 3000000;
+        std::vector<std::unique_ptr<Message>> messages;
+        messages.reserve(benchmarkCount);
+        for (size_t i = 0; i < benchmarkCount; ++i) {
+            switch (i % 3) {
+                case 0:
+                    messages.push_back(std::make_unique<EmailMessage>("user@example.com", "Hi", "Body"));
+                    break;
+                case 1:
+                    messages.push_back(std::make_unique<SMSMessage>("1234567890", "Code"));
+                    break;
+                default:
+                    messages.push_back(std::make_unique<PushNotificationMessage>("device_token", "Ping"));
+                    break;
+            }
+        }
+
+        MessageRouter<CountingSender<EmailMessage>, CountingSender<SMSMessage>, CountingSender<PushNotificationMessage>> router;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& message : messages) {
+            if (auto email = dynamic_cast<const EmailMessage*>(message.get())) {
+                router.emailSender.send(*email);
+            } else if (auto sms = dynamic_cast<const SMSMessage*>(message.get())) {
+                router.smsSender.send(*sms);
+            } else if (auto push = dynamic_cast<const PushNotificationMessage*>(message.get())) {
+                router.pushSender.send(*push);
+            }
+        }
+        std::chrono::duration<double> rttiElapsed = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (const auto& message : messages) {
+            router.route(*message);
+        }
+        std::chrono::duration<double> tagElapsed = std::chrono::steady_clock::now() - start;
+
+        size_t bytes = router.emailSender.bytes + router.smsSender.bytes + router.pushSender.bytes;
+        std::cout << "dynamic_cast dispatch: " << benchmarkCount / rttiElapsed.count() << " msg/s" << std::endl;
+        std::cout << "Tagged dispatch: " << benchmarkCount / tagElapsed.count() << " msg/s"
+                  << " (checksum " << bytes << ")" << std::endl;
+    }
+
+    // Throughput against a simulated provider with 200us per round trip
+    const size_t messageCount = 5000;
+    for (size_t batchSize : {1, 64}) {
+        ChannelConfig config;
+        config.batchSize = batchSize;
+        MessageDispatcher dispatcher;
+        auto sink = std::make_unique<SimulatedLatencyService>(std::chrono::microseconds(200));
+        SimulatedLatencyService* sinkView = sink.get();
+        size_t channel = dispatcher.addChannel(std::move(sink), config);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < messageCount; ++i) {
+            std::unique_ptr<Message> message = std::make_unique<SMSMessage>(std::to_string(i), "Benchmark");
+            while ((message = dispatcher.submit(channel, std::move(message)))) {
+                std::this_thread::yield();
+            }
+        }
+        dispatcher.shutdown();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Batch size " << batchSize << ": " << sinkView->deliveredCount() << " messages in "
+                  << elapsed.count() << " s (" << sinkView->deliveredCount() / elapsed.count() << " msg/s)" << std::endl;
+    }
+
     return 0;
 }
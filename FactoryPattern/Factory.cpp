@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <vector>
 using namespace std;
 // Abstract Base Class
 class Shape {
@@ -32,6 +33,54 @@ public:
         std::cout << "Inside Square::draw() method." << std::endl;
     }
 };
+// Type-sorted storage for many shapes: one contiguous vector per concrete type.
+// Elements are held by value, so drawAll() resolves draw() once per pool
+// instead of doing a virtual call per object in random type order.
+class ShapePool {
+private:
+    vector<Circle> circles;
+    vector<Rectangle> rectangles;
+    vector<Square> squares;
+
+    template <typename T>
+    static void drawPool(const vector<T>& pool) {
+        for (const auto& shape : pool) {
+            shape.T::draw();
+        }
+    }
+
+public:
+    // Returns false for an unknown shape type, mirroring getShape()'s nullptr
+    bool add(const string& shapeType) {
+        if (shapeType == "CIRCLE") {
+            circles.emplace_back();
+        } else if (shapeType == "RECTANGLE") {
+            rectangles.emplace_back();
+        } else if (shapeType == "SQUARE") {
+            squares.emplace_back();
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    void reserve(size_t circleCount, size_t rectangleCount, size_t squareCount) {
+        circles.reserve(circleCount);
+        rectangles.reserve(rectangleCount);
+        squares.reserve(squareCount);
+    }
+
+    size_t size() const {
+        return circles.size() + rectangles.size() + squares.size();
+    }
+
+    void drawAll() const {
+        drawPool(circles);
+        drawPool(rectangles);
+        drawPool(squares);
+    }
+};
+
 // Factory Class
 class ShapeFactory {
 public:
@@ -46,6 +95,15 @@ public:
             return nullptr;
         }
     }
+
+    // Bulk creation: shapes are stored by value in one pool per concrete type
+    static ShapePool createShapes(const vector<string>& shapeTypes) {
+        ShapePool pool;
+        for (const auto& shapeType : shapeTypes) {
+            pool.add(shapeType);
+        }
+        return pool;
+    }
 };
 int main() {
     auto shape1 = ShapeFactory::getShape("CIRCLE");
@@ -63,5 +121,10 @@ int main() {
         shape3->draw();
     }
 
+    // Create a batch of shapes in one call and draw them grouped by type
+    ShapePool pool = ShapeFactory::createShapes({"SQUARE", "CIRCLE", "RECTANGLE", "CIRCLE", "TRIANGLE"});
+    cout << "Batch created " << pool.size() << " shapes." << endl;
+    pool.drawAll();
+
     return 0;
 }
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <unordered_map>
 
 class PaymentProcessor {
 public:
@@ -27,32 +28,59 @@ public:
         std::cout << "Processing cryptocurrency payment for $" << amount << std::endl;
     }
 };
+// Non-owning handle to a shared processor; callers never delete it
+class PaymentProcessorHandle {
+private:
+    const PaymentProcessor* processor;
+
+public:
+    explicit PaymentProcessorHandle(const PaymentProcessor& processor) : processor(&processor) {}
+
+    const PaymentProcessor* operator->() const { return processor; }
+    const PaymentProcessor& operator*() const { return *processor; }
+};
+
+// Processors are stateless, so the factory hands out shared flyweight
+// instances looked up by hash instead of allocating one per call.
 class PaymentProcessorFactory {
+private:
+    static const std::unordered_map<std::string, const PaymentProcessor*>& registry() {
+        static const CreditCardProcessor creditCard;
+        static const PayPalProcessor payPal;
+        static const CryptoCurrencyProcessor crypto;
+        static const std::unordered_map<std::string, const PaymentProcessor*> processors = {
+            {"CreditCard", &creditCard},
+            {"PayPal", &payPal},
+            {"Crypto", &crypto},
+        };
+        return processors;
+    }
+
 public:
-    PaymentProcessor* getProcessor(const std::string& paymentType) {
-        if (paymentType == "CreditCard") {
-            return new CreditCardProcessor();
-        } else if (paymentType == "PayPal") {
-            return new PayPalProcessor();
-        } else if (paymentType == "Crypto") {
-            return new CryptoCurrencyProcessor();
-        } else {
+    PaymentProcessorHandle getProcessor(const std::string& paymentType) const {
+        const auto& processors = registry();
+        auto it = processors.find(paymentType);
+        if (it == processors.end()) {
             throw std::invalid_argument("Unsupported payment type: " + paymentType);
         }
+        return PaymentProcessorHandle(*it->second);
     }
 };
 int main() {
     PaymentProcessorFactory factory;
-    PaymentProcessor* processor = nullptr;
 
     try {
-        processor = factory.getProcessor("PayPal");
+        PaymentProcessorHandle processor = factory.getProcessor("PayPal");
         processor->processPayment(99.99);
+
+        // Repeated lookups return the same shared instance
+        PaymentProcessorHandle again = factory.getProcessor("PayPal");
+        std::cout << "Shared instance: " << (&*processor == &*again ? "yes" : "no") << std::endl;
+
+        factory.getProcessor("Cash");
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
     }
 
-    // Clean up the allocated processor
-    delete processor;
     return 0;
 }
@@ -1,6 +1,21 @@
 #include <iostream>
 #include <stdexcept>
 #include <cassert>
+#include <charconv>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Define the WeatherService interface
 class WeatherService {
@@ -25,6 +40,265 @@ public:
     }
 };
 
+// Latency distribution for a simulated backend, in milliseconds
+struct LatencyProfile {
+    enum Kind {
+        Fixed,
+        Uniform,
+        LogNormal,
+        Trace
+    };
+
+    Kind kind = Fixed;
+    double fixedMs = 0;
+    double minMs = 0;
+    double maxMs = 0;
+    double medianMs = 0;
+    double sigma = 0;
+    std::vector<double> traceMs;
+
+    // The factories throw std::invalid_argument for negative latencies or an empty range
+    static LatencyProfile fixed(double ms) {
+        requireLatency(ms);
+        LatencyProfile profile;
+        profile.fixedMs = ms;
+        return profile;
+    }
+
+    static LatencyProfile uniform(double minMs, double maxMs) {
+        requireLatency(minMs);
+        requireLatency(maxMs);
+        if (minMs > maxMs) {
+            throw std::invalid_argument("Uniform latency needs min <= max");
+        }
+        LatencyProfile profile;
+        profile.kind = Uniform;
+        profile.minMs = minMs;
+        profile.maxMs = maxMs;
+        return profile;
+    }
+
+    static LatencyProfile logNormal(double medianMs, double sigma) {
+        requireLatency(medianMs);
+        if (!(sigma >= 0)) {
+            throw std::invalid_argument("Lognormal latency needs sigma >= 0");
+        }
+        LatencyProfile profile;
+        profile.kind = LogNormal;
+        profile.medianMs = medianMs;
+        profile.sigma = sigma;
+        return profile;
+    }
+
+    // Reads one latency in milliseconds per line; samples replay in order and wrap around.
+    // Throws std::runtime_error on a token that is not a non-negative number.
+    static LatencyProfile fromTraceFile(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open latency trace: " + path);
+        }
+        LatencyProfile profile;
+        profile.kind = Trace;
+        std::string token;
+        while (file >> token) {
+            double ms = 0;
+            auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), ms);
+            if (error != std::errc() || end != token.data() + token.size() || !(ms >= 0)) {
+                throw std::runtime_error("Bad latency sample '" + token + "' in trace: " + path);
+            }
+            profile.traceMs.push_back(ms);
+        }
+        if (profile.traceMs.empty()) {
+            throw std::runtime_error("Latency trace is empty: " + path);
+        }
+        return profile;
+    }
+
+private:
+    static void requireLatency(double ms) {
+        if (!(ms >= 0)) {
+            throw std::invalid_argument("Latency must be a non-negative number of milliseconds");
+        }
+    }
+};
+
+// Settings for a simulated weather backend
+struct SimulationOptions {
+    LatencyProfile latency;
+    double errorRate = 0;  // probability in [0, 1] that a call throws
+    uint64_t seed = 42;
+    double temperature = 23.5;
+};
+
+// Deterministic stand-in for a remote backend with injected latency and errors.
+// Every call draws from a stream derived from (seed, call index), so a run is
+// reproducible for the same seed no matter which threads make the calls.
+class SimulatedWeatherService : public WeatherService {
+public:
+    explicit SimulatedWeatherService(const SimulationOptions& options) : options(options) {}
+
+    double getTemperature() const override {
+        uint64_t call = calls.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(latencyFor(call)));
+        if (failsOn(call)) {
+            throw std::runtime_error("Simulated weather backend failure");
+        }
+        return options.temperature;
+    }
+
+    // Latency, in milliseconds, that the given call index is delayed by
+    double latencyFor(uint64_t call) const {
+        const LatencyProfile& latency = options.latency;
+        switch (latency.kind) {
+            case LatencyProfile::Fixed:
+                return latency.fixedMs;
+            case LatencyProfile::Uniform:
+                return latency.minMs + (latency.maxMs - latency.minMs) * unitSample(call, 0);
+            case LatencyProfile::LogNormal: {
+                // Box-Muller transform for a standard normal sample
+                double u1 = 1.0 - unitSample(call, 0);
+                double u2 = unitSample(call, 1);
+                double normal = std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * std::numbers::pi * u2);
+                return latency.medianMs * std::exp(latency.sigma * normal);
+            }
+            case LatencyProfile::Trace:
+                return latency.traceMs[call % latency.traceMs.size()];
+        }
+        return 0;
+    }
+
+    bool failsOn(uint64_t call) const {
+        return unitSample(call, 2) < options.errorRate;
+    }
+
+    int callCount() const { return static_cast<int>(calls.load()); }
+
+private:
+    // splitmix64 over (seed, call, stream) mapped to [0, 1)
+    double unitSample(uint64_t call, uint64_t stream) const {
+        uint64_t x = options.seed + 0x9E3779B97F4A7C15ULL * (call * 3 + stream + 1);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return static_cast<double>(x >> 11) * 0x1.0p-53;
+    }
+
+    SimulationOptions options;
+    mutable std::atomic<uint64_t> calls{0};
+};
+
+// Caching decorator around any WeatherService.
+// - Within the TTL the cached value is returned.
+// - Within the stale window after that, the stale value is returned and one
+//   background refresh is started.
+// - On a miss, concurrent callers wait for a single in-flight fetch.
+class CachingWeatherService : public WeatherService {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CachingWeatherService(WeatherService* backend, Clock::duration ttl, Clock::duration staleWindow)
+        : backend(backend), ttl(ttl), staleWindow(staleWindow) {}
+
+    ~CachingWeatherService() override {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return !fetching; });
+        lock.unlock();
+        if (refresher.joinable()) {
+            refresher.join();
+        }
+    }
+
+    double getTemperature() const override {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            Clock::time_point now = Clock::now();
+            if (hasValue && now - fetchedAt < ttl) {
+                return value;
+            }
+            if (hasValue && now - fetchedAt < ttl + staleWindow) {
+                if (!fetching) {
+                    startBackgroundRefresh();
+                }
+                return value;
+            }
+            if (!fetching) {
+                break;
+            }
+            // Single flight: wait for the fetch already in progress
+            changed.wait(lock, [this] { return !fetching; });
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        fetching = true;
+        error = nullptr;
+        lock.unlock();
+        try {
+            double fetched = backend->getTemperature();
+            lock.lock();
+            store(fetched);
+            return fetched;
+        } catch (...) {
+            if (!lock.owns_lock()) {
+                lock.lock();
+            }
+            error = std::current_exception();
+            fetching = false;
+            changed.notify_all();
+            throw;
+        }
+    }
+
+private:
+    // Called with the mutex held
+    void store(double fetched) const {
+        value = fetched;
+        hasValue = true;
+        fetchedAt = Clock::now();
+        fetching = false;
+        changed.notify_all();
+    }
+
+    // Called with the mutex held; the previous refresher has already finished
+    // its fetch, because fetching is false
+    void startBackgroundRefresh() const {
+        fetching = true;
+        if (refresher.joinable()) {
+            refresher.join();
+        }
+        refresher = std::thread([this] {
+            double fetched = 0;
+            bool ok = true;
+            try {
+                fetched = backend->getTemperature();
+            } catch (...) {
+                ok = false;  // keep serving the stale value
+            }
+            std::lock_guard<std::mutex> guard(mutex);
+            if (ok) {
+                store(fetched);
+            } else {
+                fetching = false;
+                changed.notify_all();
+            }
+        });
+    }
+
+    std::unique_ptr<WeatherService> backend;
+    Clock::duration ttl;
+    Clock::duration staleWindow;
+
+    mutable std::mutex mutex;
+    mutable std::condition_variable changed;
+    mutable std::thread refresher;
+    mutable double value = 0;
+    mutable bool hasValue = false;
+    mutable bool fetching = false;
+    mutable Clock::time_point fetchedAt;
+    mutable std::exception_ptr error;
+};
+
 // Factory for creating instances of WeatherService
 class WeatherServiceFactory {
 public:
@@ -43,6 +317,24 @@ public:
                 throw std::invalid_argument("Invalid service type");
         }
     }
+
+    // Creates a deterministic stand-in backend for load and latency tests
+    static WeatherService* createSimulatedWeatherService(const SimulationOptions& options) {
+        if (options.errorRate < 0 || options.errorRate > 1) {
+            throw std::invalid_argument("Error rate must be between 0 and 1");
+        }
+        return new SimulatedWeatherService(options);
+    }
+
+    // Wraps a service in a caching decorator, which takes ownership of it
+    static WeatherService* createCachingWeatherService(WeatherService* service,
+                                                       std::chrono::milliseconds ttl,
+                                                       std::chrono::milliseconds staleWindow) {
+        if (service == nullptr) {
+            throw std::invalid_argument("Cannot cache a null service");
+        }
+        return new CachingWeatherService(service, ttl, staleWindow);
+    }
 };
 
 // A simple component that uses WeatherService
@@ -78,6 +370,102 @@ int main() {
 
         // Clean up
         delete mockService;
+
+        // Many concurrent operations against a slow backend behind the cache
+        SimulationOptions slowBackend;
+        slowBackend.latency = LatencyProfile::fixed(50);
+        auto* backend = static_cast<SimulatedWeatherService*>(
+            WeatherServiceFactory::createSimulatedWeatherService(slowBackend));
+        WeatherService* cachedService = WeatherServiceFactory::createCachingWeatherService(
+            backend, std::chrono::milliseconds(1000), std::chrono::milliseconds(5000));
+        WeatherComponent cachedComponent(cachedService);
+
+        std::vector<std::thread> callers;
+        for (int i = 0; i < 200; ++i) {
+            callers.emplace_back([&cachedComponent] { cachedComponent.performOperation(); });
+        }
+        for (auto& caller : callers) {
+            caller.join();
+        }
+        assert(backend->callCount() == 1 && "Test failed: concurrent misses were not coalesced");
+        std::cout << "200 concurrent operations, backend fetches: " << backend->callCount() << std::endl;
+
+        // Past the TTL the stale value is served while one refresh runs
+        std::this_thread::sleep_for(std::chrono::milliseconds(1050));
+        std::string stale = cachedComponent.performOperation();
+        std::cout << "Served stale result: " << stale << std::endl;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::cout << "Backend fetches after refresh: " << backend->callCount() << std::endl;
+        delete cachedService;  // also deletes the backend
+
+        // Jittery backend with errors: the same seed reproduces the same run
+        SimulationOptions jittery;
+        jittery.latency = LatencyProfile::logNormal(1.0, 0.8);
+        jittery.errorRate = 0.1;
+        jittery.seed = 7;
+        WeatherService* first = WeatherServiceFactory::createSimulatedWeatherService(jittery);
+        WeatherService* second = WeatherServiceFactory::createSimulatedWeatherService(jittery);
+        WeatherComponent firstComponent(first);
+        WeatherComponent secondComponent(second);
+        int failures = 0;
+        auto runStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < 50; ++i) {
+            std::string firstResult;
+            std::string secondResult;
+            try {
+                firstResult = firstComponent.performOperation();
+            } catch (const std::runtime_error&) {
+                ++failures;
+                firstResult = "error";
+            }
+            try {
+                secondResult = secondComponent.performOperation();
+            } catch (const std::runtime_error&) {
+                secondResult = "error";
+            }
+            assert(firstResult == secondResult && "Test failed: seeded runs diverged");
+        }
+        std::chrono::duration<double> runTime = std::chrono::steady_clock::now() - runStart;
+        std::cout << "Seeded lognormal run: 50 calls each, " << failures
+                  << " injected failures, " << runTime.count() << " s" << std::endl;
+        delete first;
+        delete second;
+
+        // Replay latencies recorded in a trace file
+        std::filesystem::path tracePath = std::filesystem::temp_directory_path() / "weather_latency_trace.txt";
+        {
+            std::ofstream trace(tracePath);
+            trace << "2\n5\n1\n";
+        }
+        SimulationOptions replay;
+        replay.latency = LatencyProfile::fromTraceFile(tracePath.string());
+        SimulatedWeatherService replayed(replay);
+        assert(replayed.latencyFor(0) == 2 && replayed.latencyFor(4) == 5 && "Test failed: trace replay");
+        std::cout << "Trace replay: " << replayed.latencyFor(0) << "ms, " << replayed.latencyFor(1)
+                  << "ms, " << replayed.latencyFor(2) << "ms, ..." << std::endl;
+
+        // A corrupt trace and an inverted range are rejected, not truncated or accepted
+        {
+            std::ofstream trace(tracePath);
+            trace << "2\n5x\n1\n";
+        }
+        bool corruptRejected = false;
+        try {
+            LatencyProfile::fromTraceFile(tracePath.string());
+        } catch (const std::runtime_error&) {
+            corruptRejected = true;
+        }
+        assert(corruptRejected && "Test failed: corrupt trace accepted");
+        bool rangeRejected = false;
+        try {
+            LatencyProfile::uniform(5, 1);
+        } catch (const std::invalid_argument&) {
+            rangeRejected = true;
+        }
+        assert(rangeRejected && "Test failed: uniform latency with min > max accepted");
+        std::cout << "Corrupt trace rejected: " << std::boolalpha << corruptRejected
+                  << ", inverted range rejected: " << rangeRejected << std::noboolalpha << std::endl;
+        std::filesystem::remove(tracePath);
     } catch (const std::exception& e) {
         std::cerr << "Exception caught: " << e.what() << std::endl;
         return 1;
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// A loaded asset: the list of resource files it consists of
+using AssetList = std::vector<std::string>;
+
+// Cache slot for one asset; its shared_ptr use count is the asset's refcount
+struct AssetEntry {
+    std::shared_future<AssetList> future;
+};
+
+// Handle to an asset that may still be loading. Copies share the same asset;
+// get() blocks only if the load has not finished yet. A default-constructed
+// or moved-from handle is empty: valid() is false and get() throws.
+class AssetHandle {
+public:
+    AssetHandle() = default;
+    explicit AssetHandle(std::shared_ptr<const AssetEntry> entry) : entry(std::move(entry)) {}
+
+    const AssetList& get() const {
+        if (!entry) {
+            throw std::logic_error("AssetHandle is empty");
+        }
+        return entry->future.get();
+    }
+
+    bool valid() const {
+        return entry != nullptr;
+    }
+
+    bool ready() const {
+        return entry && entry->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // Copy-on-write: returns a handle to a private copy with the resource added.
+    // The shared asset is never modified, so copying a handle stays a pointer copy.
+    AssetHandle withResource(const std::string& file) const {
+        AssetList copy = entry ? get() : AssetList();
+        copy.push_back(file);
+        return loaded(std::move(copy));
+    }
+
+    // Handle to an asset that is already in memory, bypassing the loader
+    static AssetHandle loaded(AssetList assets) {
+        std::promise<AssetList> ready;
+        ready.set_value(std::move(assets));
+        return AssetHandle(std::make_shared<const AssetEntry>(AssetEntry{ready.get_future().share()}));
+    }
+
+    // True if both handles refer to the same stored asset
+    bool sharesWith(const AssetHandle& other) const {
+        return entry == other.entry;
+    }
+
+private:
+    std::shared_ptr<const AssetEntry> entry;
+};
+
+// Loads assets on a background I/O pool and caches them by name, so each
+// asset is loaded once no matter how many characters request it.
+class AssetManager {
+public:
+    using Loader = std::function<AssetList()>;
+
+    static AssetManager& getInstance() {
+        static AssetManager instance(4);
+        return instance;
+    }
+
+    // Returns the cached asset or schedules a load; never blocks
+    AssetHandle load(const std::string& name, Loader loader) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(name);
+        if (it != cache.end()) {
+            return AssetHandle(it->second);
+        }
+        auto task = std::make_shared<std::packaged_task<AssetList()>>(std::move(loader));
+        auto entry = std::make_shared<AssetEntry>(AssetEntry{task->get_future().share()});
+        cache.emplace(name, entry);
+        enqueue([task] { (*task)(); });
+        return AssetHandle(entry);
+    }
+
+    // Drops cached assets that are fully loaded and no longer referenced by a handle
+    void releaseUnused() {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (auto it = cache.begin(); it != cache.end();) {
+            const auto& entry = it->second;
+            bool loaded = entry->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            if (loaded && entry.use_count() == 1) {
+                it = cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    size_t cachedCount() {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return cache.size();
+    }
+
+private:
+    explicit AssetManager(size_t threadCount) {
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~AssetManager() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    AssetManager(const AssetManager&) = delete;
+    AssetManager& operator=(const AssetManager&) = delete;
+
+    void enqueue(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            jobs.push_back(std::move(job));
+        }
+        queueReady.notify_one();
+    }
+
+    void work() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex cacheMutex;
+    std::unordered_map<std::string, std::shared_ptr<AssetEntry>> cache;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
@@ -3,38 +3,47 @@
 #include <vector>
 #include <chrono>
 #include <thread>
+#include "AssetManager.h"
 
 using namespace std;
 
 class GameCharacter {
 public:
     string name;
-    vector<string> textures;
-    vector<string> animations;
+    AssetHandle textures;
+    AssetHandle animations;
 
     GameCharacter(const string& name) : name(name) {
         loadTextures();
         loadAnimations();
     }
 
+    // Schedules the texture load on the asset manager's I/O pool; shared per character name
     void loadTextures() {
-        cout << "Loading textures for " << name << "..." << endl;
-        this_thread::sleep_for(chrono::seconds(3)); // Simulates a 3-second delay for loading textures
-        textures.push_back("texture1.png");
-        textures.push_back("texture2.png");
-        cout << "Textures loaded." << endl;
+        string characterName = name;
+        textures = AssetManager::getInstance().load(name + "/textures", [characterName] {
+            cout << "Loading textures for " << characterName << "..." << endl;
+            this_thread::sleep_for(chrono::seconds(3)); // Simulates a 3-second delay for loading textures
+            cout << "Textures loaded." << endl;
+            return AssetList{"texture1.png", "texture2.png"};
+        });
     }
 
+    // Schedules the animation load concurrently with the textures
     void loadAnimations() {
-        cout << "Loading animations for " << name << "..." << endl;
-        this_thread::sleep_for(chrono::seconds(3)); // Simulates a 3-second delay for loading animations
-        animations.push_back("anim1.anim");
-        animations.push_back("anim2.anim");
-        cout << "Animations loaded." << endl;
+        string characterName = name;
+        animations = AssetManager::getInstance().load(name + "/animations", [characterName] {
+            cout << "Loading animations for " << characterName << "..." << endl;
+            this_thread::sleep_for(chrono::seconds(3)); // Simulates a 3-second delay for loading animations
+            cout << "Animations loaded." << endl;
+            return AssetList{"anim1.anim", "anim2.anim"};
+        });
     }
 
+    // First use of the resources waits for any load still in flight
     void display() const {
-        cout << "Character: " << name << " ready with loaded resources." << endl;
+        size_t resourceCount = textures.get().size() + animations.get().size();
+        cout << "Character: " << name << " ready with " << resourceCount << " loaded resources." << endl;
     }
 };
 
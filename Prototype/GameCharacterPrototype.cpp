@@ -4,6 +4,11 @@
 #include <chrono>
 #include <thread>
 #include <memory>
+#include <filesystem>
+#include "../Common/AllocationCounter.h"
+#include "AssetManager.h"
+#include "PrototypeRegistry.h"
+#include "PrototypeSnapshot.h"
 
 using namespace std;
 
@@ -14,37 +19,81 @@ public:
     virtual ~GameCharacterPrototype() {}
 };
 
+// Snapshot layout of a GameCharacter with its resolved asset lists
+struct GameCharacterSnapshotRecord {
+    StringRef name;
+    StringListRef textures;
+    StringListRef animations;
+};
+
 class GameCharacter : public GameCharacterPrototype {
 public:
     string name;
-    vector<string> textures;
-    vector<string> animations;
+    AssetHandle textures;
+    AssetHandle animations;
 
     GameCharacter(const string& name) : name(name) {
         loadTextures();
         loadAnimations();
     }
 
+    // Builds a character from already loaded assets, e.g. from a snapshot
+    GameCharacter(const string& name, AssetList textureFiles, AssetList animationFiles)
+        : name(name),
+          textures(AssetHandle::loaded(move(textureFiles))),
+          animations(AssetHandle::loaded(move(animationFiles))) {}
+
+    // Schedules the texture load on the asset manager's I/O pool; shared per character name
     void loadTextures() {
-        cout << "Loading textures for " << name << "..." << endl;
-        this_thread::sleep_for(chrono::seconds(3));
-        textures.push_back("texture1.png");
-        textures.push_back("texture2.png");
-        cout << "Textures loaded." << endl;
+        string characterName = name;
+        textures = AssetManager::getInstance().load(name + "/textures", [characterName] {
+            cout << "Loading textures for " << characterName << "..." << endl;
+            this_thread::sleep_for(chrono::seconds(3));
+            cout << "Textures loaded." << endl;
+            return AssetList{"texture1.png", "texture2.png"};
+        });
     }
 
+    // Schedules the animation load concurrently with the textures
     void loadAnimations() {
-        cout << "Loading animations for " << name << "..." << endl;
-        this_thread::sleep_for(chrono::seconds(3));
-        animations.push_back("anim1.anim");
-        animations.push_back("anim2.anim");
-        cout << "Animations loaded." << endl;
+        string characterName = name;
+        animations = AssetManager::getInstance().load(name + "/animations", [characterName] {
+            cout << "Loading animations for " << characterName << "..." << endl;
+            this_thread::sleep_for(chrono::seconds(3));
+            cout << "Animations loaded." << endl;
+            return AssetList{"anim1.anim", "anim2.anim"};
+        });
     }
 
+    // First use of the resources waits for any load still in flight
     void display() const override {
-        cout << "Character: " << name << " ready with loaded resources." << endl;
+        size_t resourceCount = textures.get().size() + animations.get().size();
+        cout << "Character: " << name << " ready with " << resourceCount << " loaded resources." << endl;
+    }
+
+    // Variations on a clone get their own copy of the list; other clones keep sharing
+    void addTexture(const string& file) {
+        textures = textures.withResource(file);
+    }
+
+    void addAnimation(const string& file) {
+        animations = animations.withResource(file);
     }
 
+    void saveSnapshot(SnapshotWriter& writer, const string& key) const {
+        GameCharacterSnapshotRecord record{writer.addString(name), writer.addStrings(textures.get()),
+                                           writer.addStrings(animations.get())};
+        writer.addRecord(SnapshotKind::GameCharacter, key, record);
+    }
+
+    // Clones straight from a mapped snapshot record, skipping the asset loads
+    static GameCharacter fromSnapshot(const SnapshotFile& snapshot, const string& key) {
+        const auto& record = snapshot.record<GameCharacterSnapshotRecord>(SnapshotKind::GameCharacter, key);
+        return GameCharacter(string(snapshot.str(record.name)), snapshot.strings(record.textures),
+                             snapshot.strings(record.animations));
+    }
+
+    // Copies the asset handles, not the asset lists
     unique_ptr<GameCharacterPrototype> clone() const override {
         cout << "Cloning character: " << name << "..." << endl;
         auto cloned = make_unique<GameCharacter>(*this);
@@ -63,6 +112,7 @@ int main() {
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double> elapsed = end - start;
     cout << "Time taken to create Hero: " << elapsed.count() << " seconds." << endl;
+    double constructionSeconds = elapsed.count();
 
     start = chrono::high_resolution_clock::now();
     cout << "Cloning Hero character..." << endl;
@@ -73,5 +123,80 @@ int main() {
     elapsed = end - start;
     cout << "Time taken to clone Hero: " << elapsed.count() << " seconds." << endl;
 
+    // A clone that changes its textures detaches only that list
+    auto variant = hero->clone();
+    auto& variantCharacter = static_cast<GameCharacter&>(*variant);
+    variantCharacter.addTexture("texture_armor.png");
+    const auto& heroCharacter = static_cast<const GameCharacter&>(*hero);
+    cout << "Variant shares textures: " << boolalpha << variantCharacter.textures.sharesWith(heroCharacter.textures)
+         << ", shares animations: " << variantCharacter.animations.sharesWith(heroCharacter.animations) << endl;
+
+    // Crowd benchmark: shared handles versus deep-copied asset lists.
+    // Uses the copy constructor that clone() wraps, without its logging.
+    const size_t crowdSize = 100000;
+    vector<unique_ptr<GameCharacter>> crowd;
+    crowd.reserve(crowdSize);
+    size_t bytesBefore = allocatedBytes();
+    start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < crowdSize; ++i) {
+        crowd.push_back(make_unique<GameCharacter>(heroCharacter));
+    }
+    end = chrono::high_resolution_clock::now();
+    double sharedSeconds = chrono::duration<double>(end - start).count();
+    size_t sharedBytes = allocatedBytes() - bytesBefore;
+
+    struct DeepCopiedAssets {
+        string name;
+        vector<string> textures;
+        vector<string> animations;
+    };
+    vector<unique_ptr<DeepCopiedAssets>> deepCrowd;
+    deepCrowd.reserve(crowdSize);
+    bytesBefore = allocatedBytes();
+    start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < crowdSize; ++i) {
+        deepCrowd.push_back(make_unique<DeepCopiedAssets>(
+            DeepCopiedAssets{heroCharacter.name, heroCharacter.textures.get(), heroCharacter.animations.get()}));
+    }
+    end = chrono::high_resolution_clock::now();
+    double deepSeconds = chrono::duration<double>(end - start).count();
+    size_t deepBytes = allocatedBytes() - bytesBefore;
+
+    cout << crowdSize << " clones, shared assets: " << sharedBytes / crowdSize << " bytes and "
+         << sharedSeconds * 1e9 / crowdSize << " ns per clone" << endl;
+    cout << crowdSize << " clones, deep copies:   " << deepBytes / crowdSize << " bytes and "
+         << deepSeconds * 1e9 / crowdSize << " ns per clone" << endl;
+
+    // Bulk spawn from the registry: all clones in one contiguous allocation
+    PrototypeRegistry registry;
+    registry.add("Hero", heroCharacter);
+    bytesBefore = allocatedBytes();
+    start = chrono::high_resolution_clock::now();
+    vector<GameCharacter> spawned = registry.cloneN<GameCharacter>("Hero", crowdSize);
+    end = chrono::high_resolution_clock::now();
+    double bulkSeconds = chrono::duration<double>(end - start).count();
+    size_t bulkBytes = allocatedBytes() - bytesBefore;
+    cout << spawned.size() << " clones, cloneN:      " << bulkBytes / crowdSize << " bytes and "
+         << bulkSeconds * 1e9 / crowdSize << " ns per clone" << endl;
+
+    // Cold start: a restarted process maps the snapshot instead of reloading assets
+    string snapshotPath = (filesystem::temp_directory_path() / "characters.snap").string();
+    {
+        SnapshotWriter writer;
+        heroCharacter.saveSnapshot(writer, "Hero");
+        writer.writeToFile(snapshotPath);
+    }
+    start = chrono::high_resolution_clock::now();
+    {
+        SnapshotFile snapshot(snapshotPath);
+        GameCharacter restored = GameCharacter::fromSnapshot(snapshot, "Hero");
+        restored.display();
+    }
+    end = chrono::high_resolution_clock::now();
+    elapsed = end - start;
+    cout << "Cold start from snapshot: " << elapsed.count() << " seconds, against " << constructionSeconds
+         << " seconds for full construction." << endl;
+    filesystem::remove(snapshotPath);
+
     return 0;
 }
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <any>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Registry of named prototypes of any copyable type. cloneN() copies a
+// prototype N times into one contiguous, type-homogeneous vector: a single
+// allocation for the objects instead of one unique_ptr per clone.
+class PrototypeRegistry {
+public:
+    template <typename T>
+    void add(const std::string& key, T prototype) {
+        prototypes[key] = std::move(prototype);
+    }
+
+    bool contains(const std::string& key) const {
+        return prototypes.count(key) != 0;
+    }
+
+    // Throws if the key is unknown or registered with a different type
+    template <typename T>
+    const T& get(const std::string& key) const {
+        auto it = prototypes.find(key);
+        if (it == prototypes.end()) {
+            throw std::invalid_argument("Unknown prototype: " + key);
+        }
+        const T* prototype = std::any_cast<T>(&it->second);
+        if (prototype == nullptr) {
+            throw std::invalid_argument("Prototype " + key + " has a different type");
+        }
+        return *prototype;
+    }
+
+    template <typename T>
+    std::vector<T> cloneN(const std::string& key, size_t count) const {
+        return std::vector<T>(count, get<T>(key));
+    }
+
+private:
+    std::unordered_map<std::string, std::any> prototypes;
+};
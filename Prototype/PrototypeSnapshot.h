@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary snapshot of named prototypes, read back through mmap.
+//
+// Layout (little-endian, offsets relative to the data section):
+//   SnapshotHeader
+//   SnapshotEntry[recordCount]   sorted by key
+//   data section                 fixed-size records, string refs and characters
+//
+// Records are trivially copyable structs whose strings are StringRefs into the
+// data section, so a mapped record is used in place with no parsing. Records
+// are written byte for byte, so they must not have implicit padding: declare
+// and zero padding fields explicitly. Offsets are 32-bit, so the data section
+// is limited to 4 GB; the writer throws std::length_error beyond that.
+
+// Identifies the prototype type of a record; values are part of the file format
+enum class SnapshotKind : uint32_t {
+    Truck = 1,
+    GameCharacter = 2,
+    VirtualMachine = 3
+};
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Contiguous array of StringRefs
+struct StringListRef {
+    uint32_t offset;
+    uint32_t count;
+};
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t dataSize;
+};
+
+struct SnapshotEntry {
+    SnapshotKind kind;
+    StringRef key;
+    uint32_t recordOffset;
+    uint32_t recordSize;
+    uint32_t reserved;  // keeps the entry table, and so the data section, 8-byte aligned
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0 && sizeof(SnapshotEntry) % 8 == 0,
+              "Header and entry table must keep the data section 8-byte aligned");
+
+constexpr char snapshotMagic[4] = {'P', 'S', 'N', 'P'};
+constexpr uint32_t snapshotVersion = 1;
+
+class SnapshotWriter {
+public:
+    StringRef addString(std::string_view text) {
+        checkRoom(text.size());
+        StringRef ref{static_cast<uint32_t>(data.size()), static_cast<uint32_t>(text.size())};
+        data.insert(data.end(), text.begin(), text.end());
+        return ref;
+    }
+
+    StringListRef addStrings(const std::vector<std::string>& strings) {
+        std::vector<StringRef> refs;
+        refs.reserve(strings.size());
+        for (const auto& text : strings) {
+            refs.push_back(addString(text));
+        }
+        uint32_t offset = append(refs.data(), refs.size() * sizeof(StringRef));
+        return StringListRef{offset, static_cast<uint32_t>(refs.size())};
+    }
+
+    template <typename Record>
+    void addRecord(SnapshotKind kind, std::string_view key, const Record& record) {
+        static_assert(std::is_trivially_copyable_v<Record>, "Snapshot records must be trivially copyable");
+        static_assert(alignof(Record) <= 8, "Snapshot records are 8-byte aligned");
+        for (const auto& entry : entries) {
+            if (keyOf(entry) == key) {
+                throw std::invalid_argument("Duplicate snapshot key: " + std::string(key));
+            }
+        }
+        StringRef keyRef = addString(key);
+        uint32_t offset = append(&record, sizeof(Record));
+        entries.push_back(SnapshotEntry{kind, keyRef, offset, static_cast<uint32_t>(sizeof(Record)), 0});
+    }
+
+    void writeToFile(const std::string& path) const {
+        if (entries.size() > UINT32_MAX) {
+            throw std::length_error("Too many snapshot records");
+        }
+        std::vector<SnapshotEntry> sorted = entries;
+        std::sort(sorted.begin(), sorted.end(), [this](const SnapshotEntry& a, const SnapshotEntry& b) {
+            return keyOf(a) < keyOf(b);
+        });
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+        header.version = snapshotVersion;
+        header.recordCount = static_cast<uint32_t>(sorted.size());
+        header.dataSize = static_cast<uint32_t>(data.size());
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot write snapshot: " + path);
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(sorted.data()), sorted.size() * sizeof(SnapshotEntry));
+        file.write(data.data(), data.size());
+        if (!file) {
+            throw std::runtime_error("Failed writing snapshot: " + path);
+        }
+    }
+
+private:
+    // Appends 8-byte aligned bytes; the data section itself starts 8-byte aligned
+    uint32_t append(const void* bytes, size_t size) {
+        checkRoom(size + 7);
+        data.resize((data.size() + 7) & ~size_t(7));
+        uint32_t offset = static_cast<uint32_t>(data.size());
+        data.resize(data.size() + size);
+        std::memcpy(data.data() + offset, bytes, size);
+        return offset;
+    }
+
+    // Throws if size more bytes would take the data section past 32-bit offsets
+    void checkRoom(size_t size) const {
+        if (size > UINT32_MAX - data.size()) {
+            throw std::length_error("Snapshot data would exceed 4 GB");
+        }
+    }
+
+    std::string_view keyOf(const SnapshotEntry& entry) const {
+        return std::string_view(data.data() + entry.key.offset, entry.key.length);
+    }
+
+    std::vector<char> data;
+    std::vector<SnapshotEntry> entries;
+};
+
+// Read-only, memory-mapped snapshot. Only the header and entry table are
+// validated on open; records and strings are accessed in place.
+class SnapshotFile {
+public:
+    explicit SnapshotFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open snapshot: " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+            ::close(fd);
+            throw std::runtime_error("Snapshot is truncated: " + path);
+        }
+        size = static_cast<size_t>(info.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Cannot map snapshot: " + path);
+        }
+        base = static_cast<const char*>(mapped);
+
+        const auto* header = reinterpret_cast<const SnapshotHeader*>(base);
+        size_t tableSize = size_t(header->recordCount) * sizeof(SnapshotEntry);
+        if (std::memcmp(header->magic, snapshotMagic, sizeof(header->magic)) != 0 ||
+            header->version != snapshotVersion ||
+            sizeof(SnapshotHeader) + tableSize + header->dataSize != size) {
+            ::munmap(const_cast<char*>(base), size);
+            throw std::runtime_error("Not a valid version " + std::to_string(snapshotVersion) + " snapshot: " + path);
+        }
+        entries = reinterpret_cast<const SnapshotEntry*>(base + sizeof(SnapshotHeader));
+        entryCount = header->recordCount;
+        data = base + sizeof(SnapshotHeader) + tableSize;
+        dataSize = header->dataSize;
+    }
+
+    ~SnapshotFile() {
+        ::munmap(const_cast<char*>(base), size);
+    }
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    size_t recordCount() const { return entryCount; }
+
+    // Binary search over the sorted entry table; throws on unknown key or kind mismatch
+    template <typename Record>
+    const Record& record(SnapshotKind kind, std::string_view key) const {
+        const SnapshotEntry* end = entries + entryCount;
+        const SnapshotEntry* entry = std::lower_bound(entries, end, key,
+            [this](const SnapshotEntry& e, std::string_view k) { return str(e.key) < k; });
+        if (entry == end || str(entry->key) != key) {
+            throw std::invalid_argument("Unknown snapshot key: " + std::string(key));
+        }
+        if (entry->kind != kind || entry->recordSize != sizeof(Record)) {
+            throw std::invalid_argument("Snapshot record " + std::string(key) + " has a different type");
+        }
+        checkRange(entry->recordOffset, sizeof(Record));
+        return *reinterpret_cast<const Record*>(data + entry->recordOffset);
+    }
+
+    std::string_view str(StringRef ref) const {
+        checkRange(ref.offset, ref.length);
+        return std::string_view(data + ref.offset, ref.length);
+    }
+
+    std::vector<std::string> strings(StringListRef list) const {
+        checkRange(list.offset, size_t(list.count) * sizeof(StringRef));
+        const auto* refs = reinterpret_cast<const StringRef*>(data + list.offset);
+        std::vector<std::string> result;
+        result.reserve(list.count);
+        for (uint32_t i = 0; i < list.count; ++i) {
+            result.emplace_back(str(refs[i]));
+        }
+        return result;
+    }
+
+private:
+    void checkRange(size_t offset, size_t length) const {
+        if (offset > dataSize || length > dataSize - offset) {
+            throw std::runtime_error("Snapshot reference out of range");
+        }
+    }
+
+    const char* base = nullptr;
+    size_t size = 0;
+    const SnapshotEntry* entries = nullptr;
+    size_t entryCount = 0;
+    const char* data = nullptr;
+    size_t dataSize = 0;
+};
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <filesystem>
+#include "PrototypeRegistry.h"
+#include "PrototypeSnapshot.h"
 
 // Prototype base class
 class VehiclePrototype {
@@ -10,6 +13,16 @@ public:
     virtual ~VehiclePrototype() {}
 };
 
+// Snapshot layout of a Truck
+struct TruckSnapshotRecord {
+    StringRef model;
+    StringRef color;
+    int32_t horsepower;
+    uint32_t padding;  // written as zero, so no stack bytes reach the file
+    double capacity;
+};
+static_assert(sizeof(TruckSnapshotRecord) == 32, "TruckSnapshotRecord must have no implicit padding");
+
 // Concrete class implementing Prototype
 class Truck : public VehiclePrototype {
 public:
@@ -31,6 +44,18 @@ public:
     std::unique_ptr<VehiclePrototype> clone() const override {
         return std::make_unique<Truck>(*this);
     }
+
+    void saveSnapshot(SnapshotWriter& writer, const std::string& key) const {
+        TruckSnapshotRecord record{writer.addString(model), writer.addString(color), horsepower, 0, capacity};
+        writer.addRecord(SnapshotKind::Truck, key, record);
+    }
+
+    // Clones straight from a mapped snapshot record
+    static Truck fromSnapshot(const SnapshotFile& snapshot, const std::string& key) {
+        const auto& record = snapshot.record<TruckSnapshotRecord>(SnapshotKind::Truck, key);
+        return Truck(std::string(snapshot.str(record.model)), std::string(snapshot.str(record.color)),
+                     record.horsepower, record.capacity);
+    }
 };
 
 int main() {
@@ -41,5 +66,26 @@ int main() {
     auto clonedTruck = truckPrototype->clone();
     clonedTruck->display();
 
+    // Spawn a whole fleet from a registered prototype in one allocation
+    PrototypeRegistry registry;
+    registry.add("ford", Truck("Ford Truck", "White", 350, 2.5));
+    registry.add("volvo", Truck("Volvo FH16", "Blue", 750, 40.0));
+
+    std::vector<Truck> fleet = registry.cloneN<Truck>("volvo", 1000);
+    std::cout << "Fleet of " << fleet.size() << " trucks, first: ";
+    fleet.front().display();
+
+    // Persist the prototypes and restore one from the mapped snapshot
+    std::string snapshotPath = (std::filesystem::temp_directory_path() / "trucks.snap").string();
+    SnapshotWriter writer;
+    registry.get<Truck>("ford").saveSnapshot(writer, "ford");
+    registry.get<Truck>("volvo").saveSnapshot(writer, "volvo");
+    writer.writeToFile(snapshotPath);
+
+    SnapshotFile snapshot(snapshotPath);
+    std::cout << "Restored from snapshot: ";
+    Truck::fromSnapshot(snapshot, "volvo").display();
+    std::filesystem::remove(snapshotPath);
+
     return 0;
 }
@@ -2,24 +2,57 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <filesystem>
+#include "PrototypeRegistry.h"
+#include "PrototypeSnapshot.h"
 
 using namespace std;
 
+// Immutable block of installed software shared by every VM cloned on top of it
+struct SoftwareLayer {
+    shared_ptr<const SoftwareLayer> parent;
+    vector<string> software;
+};
+
+// Snapshot layout of a VirtualMachine; software is stored flattened
+struct VirtualMachineSnapshotRecord {
+    StringRef OS;
+    int32_t CPU_cores;
+    int32_t RAM;
+    StringListRef software;
+};
+
 // Represents a virtual machine with configurable software and system settings
 class VirtualMachine {
 public:
     string OS;
     int CPU_cores;
     int RAM;
+    // Software installed since the VM was last sealed, on top of its shared
+    // base layers; forEachSoftware() visits the full list
     vector<string> installedSoftware;
 
+    // Layers a seal() may stack before it collapses the chain into one
+    static constexpr size_t maxLayerDepth = 8;
+
     // Constructor to initialize a VM with OS, CPU, and RAM
     VirtualMachine(const string& OS, int CPU_cores, int RAM) 
         : OS(OS), CPU_cores(CPU_cores), RAM(RAM) {}
 
-    // Copy constructor for cloning
+    // Copy constructor for cloning: the copy shares the source's sealed layers
+    // and copies only its unsealed additions. Seal a golden image first so its
+    // clones copy nothing but the layer pointer.
     VirtualMachine(const VirtualMachine& other) 
-        : OS(other.OS), CPU_cores(other.CPU_cores), RAM(other.RAM), installedSoftware(other.installedSoftware) {}
+        : OS(other.OS), CPU_cores(other.CPU_cores), RAM(other.RAM),
+          installedSoftware(other.installedSoftware), baseLayer(other.baseLayer) {}
 
     // Method to install software on the VM
     void installSoftware(const string& software) {
@@ -32,16 +65,310 @@ public:
         cout << "VM Configuration: " << OS << " with " 
              << CPU_cores << " CPU cores and " << RAM << "GB RAM." << endl;
         cout << "Installed Software: ";
+        forEachSoftware([](const string& software) { cout << software << " "; });
+        cout << endl;
+    }
+
+    // Visits all software in install order, oldest layer first
+    template <typename Visitor>
+    void forEachSoftware(Visitor visit) const {
+        vector<const SoftwareLayer*> layers;
+        for (const SoftwareLayer* layer = baseLayer.get(); layer != nullptr; layer = layer->parent.get()) {
+            layers.push_back(layer);
+        }
+        for (auto layer = layers.rbegin(); layer != layers.rend(); ++layer) {
+            for (const auto& software : (*layer)->software) {
+                visit(software);
+            }
+        }
         for (const auto& software : installedSoftware) {
-            cout << software << " ";
+            visit(software);
         }
-        cout << endl;
+    }
+
+    // Moves this VM's own additions into a new immutable layer on top of its
+    // base; the software list seen through forEachSoftware is unchanged. Once
+    // the chain is maxLayerDepth deep, the layers above the bottom one (the
+    // golden image, shared by the whole fleet) are merged with the additions,
+    // so the image stays shared and only this VM's changes are copied.
+    void seal() {
+        if (installedSoftware.empty()) {
+            return;
+        }
+        if (layerDepth() < maxLayerDepth) {
+            baseLayer = make_shared<const SoftwareLayer>(SoftwareLayer{baseLayer, move(installedSoftware)});
+            installedSoftware.clear();
+            return;
+        }
+        vector<const SoftwareLayer*> above;
+        const SoftwareLayer* bottom = baseLayer.get();
+        for (; bottom->parent != nullptr; bottom = bottom->parent.get()) {
+            above.push_back(bottom);
+        }
+        vector<string> merged;
+        for (auto layer = above.rbegin(); layer != above.rend(); ++layer) {
+            merged.insert(merged.end(), (*layer)->software.begin(), (*layer)->software.end());
+        }
+        merged.insert(merged.end(), make_move_iterator(installedSoftware.begin()),
+                      make_move_iterator(installedSoftware.end()));
+        installedSoftware.clear();
+        shared_ptr<const SoftwareLayer> root = above.empty() ? baseLayer : above.back()->parent;
+        baseLayer = make_shared<const SoftwareLayer>(SoftwareLayer{move(root), move(merged)});
+    }
+
+    // Copies all layers into this VM's own list and drops the shared chain
+    void flatten() {
+        vector<string> all;
+        forEachSoftware([&all](const string& software) { all.push_back(software); });
+        installedSoftware = move(all);
+        baseLayer.reset();
+    }
+
+    // Visits the sealed layers, newest first
+    template <typename Visitor>
+    void forEachLayer(Visitor visit) const {
+        for (const SoftwareLayer* layer = baseLayer.get(); layer != nullptr; layer = layer->parent.get()) {
+            visit(*layer);
+        }
+    }
+
+    // True if layer is one of this VM's sealed layers
+    bool sharesLayer(const SoftwareLayer& layer) const {
+        bool found = false;
+        forEachLayer([&found, &layer](const SoftwareLayer& own) { found = found || &own == &layer; });
+        return found;
+    }
+
+    size_t layerDepth() const {
+        size_t depth = 0;
+        for (const SoftwareLayer* layer = baseLayer.get(); layer != nullptr; layer = layer->parent.get()) {
+            ++depth;
+        }
+        return depth;
     }
 
     // Method to clone the VM
     unique_ptr<VirtualMachine> clone() const {
         return make_unique<VirtualMachine>(*this);
     }
+
+    void saveSnapshot(SnapshotWriter& writer, const string& key) const {
+        vector<string> software;
+        forEachSoftware([&software](const string& name) { software.push_back(name); });
+        VirtualMachineSnapshotRecord record{writer.addString(OS), CPU_cores, RAM, writer.addStrings(software)};
+        writer.addRecord(SnapshotKind::VirtualMachine, key, record);
+    }
+
+    // Clones straight from a mapped snapshot record
+    static VirtualMachine fromSnapshot(const SnapshotFile& snapshot, const string& key) {
+        const auto& record = snapshot.record<VirtualMachineSnapshotRecord>(SnapshotKind::VirtualMachine, key);
+        VirtualMachine vm(string(snapshot.str(record.OS)), record.CPU_cores, record.RAM);
+        vm.installedSoftware = snapshot.strings(record.software);
+        return vm;
+    }
+
+private:
+    // Shared, immutable software below installedSoftware
+    shared_ptr<const SoftwareLayer> baseLayer;
+};
+
+// A software package to install, with the packages it depends on
+struct SoftwarePackage {
+    string name;
+    vector<string> dependsOn;
+    chrono::milliseconds installTime;
+};
+
+// Packages to install on one clone; dependencies must be in the same plan
+using InstallPlan = vector<SoftwarePackage>;
+
+// Timing of one provisioning stage (all installs of one package name)
+struct StageTiming {
+    size_t count = 0;
+    double totalSeconds = 0;
+    double maxSeconds = 0;
+};
+
+struct ProvisioningReport {
+    double cloneSeconds = 0;
+    double makespanSeconds = 0;
+    map<string, StageTiming> stages;
+};
+
+// Provisions a fleet from a golden VM. Installs run concurrently on a thread
+// pool in dependency order. A clone is admitted only while the host budget
+// has room for its CPU_cores and RAM, and releases them when its plan is done.
+class ProvisioningScheduler {
+public:
+    ProvisioningScheduler(int hostCores, int hostRAM, size_t threadCount)
+        : hostCores(hostCores), hostRAM(hostRAM), threadCount(threadCount) {
+        if (threadCount == 0) {
+            throw invalid_argument("Provisioning needs at least one thread");
+        }
+    }
+
+    vector<unique_ptr<VirtualMachine>> provision(const VirtualMachine& golden, const vector<InstallPlan>& plans,
+                                                 ProvisioningReport& report) {
+        if (golden.CPU_cores > hostCores || golden.RAM > hostRAM) {
+            throw invalid_argument("Golden VM does not fit in the host budget");
+        }
+        using Clock = chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+
+        vector<unique_ptr<VirtualMachine>> fleet;
+        fleet.reserve(plans.size());
+        vms.clear();
+        for (const auto& plan : plans) {
+            fleet.push_back(golden.clone());
+            vms.push_back(buildGraph(plan));
+        }
+        report = ProvisioningReport();
+        report.cloneSeconds = chrono::duration<double>(Clock::now() - start).count();
+
+        freeCores = hostCores;
+        freeRAM = hostRAM;
+        nextToAdmit = 0;
+        unfinished = plans.size();
+        ready.clear();
+        admit(golden);
+
+        vector<thread> workers;
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([&] { work(golden, plans, fleet, report); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        report.makespanSeconds = chrono::duration<double>(Clock::now() - start).count();
+        return fleet;
+    }
+
+private:
+    struct VMState {
+        vector<int> pendingDependencies;   // per package
+        vector<vector<size_t>> dependents; // per package
+        size_t remaining = 0;
+    };
+
+    struct Task {
+        size_t vm;
+        size_t package;
+    };
+
+    // Builds the dependency graph of a plan and rejects unknown packages and cycles
+    static VMState buildGraph(const InstallPlan& plan) {
+        VMState state;
+        unordered_map<string, size_t> index;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            index[plan[i].name] = i;
+        }
+        state.pendingDependencies.assign(plan.size(), 0);
+        state.dependents.resize(plan.size());
+        for (size_t i = 0; i < plan.size(); ++i) {
+            for (const auto& dependency : plan[i].dependsOn) {
+                auto it = index.find(dependency);
+                if (it == index.end()) {
+                    throw invalid_argument(plan[i].name + " depends on unknown package " + dependency);
+                }
+                state.dependents[it->second].push_back(i);
+                ++state.pendingDependencies[i];
+            }
+        }
+        state.remaining = plan.size();
+
+        // Kahn's algorithm on a copy to detect cycles up front
+        vector<int> pending = state.pendingDependencies;
+        vector<size_t> queue;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            if (pending[i] == 0) {
+                queue.push_back(i);
+            }
+        }
+        for (size_t head = 0; head < queue.size(); ++head) {
+            for (size_t dependent : state.dependents[queue[head]]) {
+                if (--pending[dependent] == 0) {
+                    queue.push_back(dependent);
+                }
+            }
+        }
+        if (queue.size() != plan.size()) {
+            throw invalid_argument("Install plan has a dependency cycle");
+        }
+        return state;
+    }
+
+    // Called with the mutex held
+    void admit(const VirtualMachine& golden) {
+        while (nextToAdmit < vms.size() && freeCores >= golden.CPU_cores && freeRAM >= golden.RAM) {
+            size_t vm = nextToAdmit++;
+            if (vms[vm].remaining == 0) {
+                --unfinished;
+                continue;
+            }
+            freeCores -= golden.CPU_cores;
+            freeRAM -= golden.RAM;
+            for (size_t package = 0; package < vms[vm].pendingDependencies.size(); ++package) {
+                if (vms[vm].pendingDependencies[package] == 0) {
+                    ready.push_back({vm, package});
+                }
+            }
+        }
+        changed.notify_all();
+    }
+
+    void work(const VirtualMachine& golden, const vector<InstallPlan>& plans,
+              vector<unique_ptr<VirtualMachine>>& fleet, ProvisioningReport& report) {
+        unique_lock<mutex> lock(stateMutex);
+        for (;;) {
+            changed.wait(lock, [this] { return !ready.empty() || unfinished == 0; });
+            if (ready.empty()) {
+                return;
+            }
+            Task task = ready.front();
+            ready.pop_front();
+            const SoftwarePackage& package = plans[task.vm][task.package];
+
+            lock.unlock();
+            auto installStart = chrono::steady_clock::now();
+            this_thread::sleep_for(package.installTime);  // simulated install
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - installStart).count();
+            lock.lock();
+
+            fleet[task.vm]->installedSoftware.push_back(package.name);
+            StageTiming& stage = report.stages[package.name];
+            ++stage.count;
+            stage.totalSeconds += seconds;
+            stage.maxSeconds = max(stage.maxSeconds, seconds);
+
+            VMState& vm = vms[task.vm];
+            for (size_t dependent : vm.dependents[task.package]) {
+                if (--vm.pendingDependencies[dependent] == 0) {
+                    ready.push_back({task.vm, dependent});
+                }
+            }
+            if (--vm.remaining == 0) {
+                --unfinished;
+                freeCores += golden.CPU_cores;
+                freeRAM += golden.RAM;
+                admit(golden);
+            }
+            changed.notify_all();
+        }
+    }
+
+    int hostCores;
+    int hostRAM;
+    size_t threadCount;
+
+    mutex stateMutex;
+    condition_variable changed;
+    vector<VMState> vms;
+    deque<Task> ready;
+    size_t nextToAdmit = 0;
+    size_t unfinished = 0;
+    int freeCores = 0;
+    int freeRAM = 0;
 };
 
 int main() {
@@ -57,5 +384,90 @@ int main() {
     clonedVM->installSoftware("PostgreSQL");
     clonedVM->displayConfiguration();
 
+    // Golden images in a registry, cloned in bulk into contiguous storage.
+    // Sealed first, so the clones share its software instead of copying it.
+    vm.seal();
+    PrototypeRegistry registry;
+    registry.add("ubuntu-web", vm);
+    vector<VirtualMachine> webFarm = registry.cloneN<VirtualMachine>("ubuntu-web", 3);
+    webFarm[2].installSoftware("Redis");
+    for (const auto& webVM : webFarm) {
+        webVM.displayConfiguration();
+    }
+
+    // Golden images survive restarts in a memory-mapped snapshot
+    string snapshotPath = (filesystem::temp_directory_path() / "golden_vms.snap").string();
+    {
+        SnapshotWriter writer;
+        registry.get<VirtualMachine>("ubuntu-web").saveSnapshot(writer, "ubuntu-web");
+        writer.writeToFile(snapshotPath);
+    }
+    {
+        SnapshotFile snapshot(snapshotPath);
+        cout << "Restored from snapshot: ";
+        VirtualMachine::fromSnapshot(snapshot, "ubuntu-web").displayConfiguration();
+    }
+    filesystem::remove(snapshotPath);
+
+    // Thousands of clones of a large golden image store only their deltas
+    VirtualMachine golden("Debian 12", 8, 32);
+    for (int i = 0; i < 200; ++i) {
+        golden.installedSoftware.push_back("package-" + to_string(i));
+    }
+    golden.seal();
+    vector<unique_ptr<VirtualMachine>> clones;
+    size_t storedEntries = 0;
+    for (int i = 0; i < 5000; ++i) {
+        clones.push_back(golden.clone());
+        clones.back()->installedSoftware.push_back("app-" + to_string(i));
+        storedEntries += clones.back()->installedSoftware.size();
+    }
+    storedEntries += 200;  // the golden layer, stored once
+    cout << clones.size() << " clones of a 200-package image store " << storedEntries
+         << " software entries instead of " << clones.size() * 201 << endl;
+
+    clones.front()->flatten();
+    cout << "Flattened clone owns " << clones.front()->installedSoftware.size()
+         << " entries, layer depth " << clones.front()->layerDepth() << endl;
+
+    // Cloning clones: sealing each generation stacks a layer, up to the cap
+    auto generation = golden.clone();
+    size_t deepest = 0;
+    for (int i = 0; i < 100; ++i) {
+        generation->installedSoftware.push_back("patch-" + to_string(i));
+        generation->seal();
+        generation = generation->clone();
+        deepest = max(deepest, generation->layerDepth());
+    }
+    size_t softwareCount = 0;
+    generation->forEachSoftware([&softwareCount](const string&) { ++softwareCount; });
+    size_t ownEntries = 0;
+    generation->forEachLayer([&ownEntries, &golden](const SoftwareLayer& layer) {
+        if (!golden.sharesLayer(layer)) {
+            ownEntries += layer.software.size();
+        }
+    });
+    cout << "100 generations of clones: " << softwareCount << " packages, layer depth never above "
+         << deepest << ", " << ownEntries << " entries stored outside the shared golden image" << endl;
+
+    // Provision 8 clones on a 16-core / 32GB host: at most 4 VMs at a time
+    InstallPlan webStack = {
+        {"Docker", {}, chrono::milliseconds(40)},
+        {"PostgreSQL", {}, chrono::milliseconds(50)},
+        {"Node.js", {"Docker"}, chrono::milliseconds(30)},
+        {"WebApp", {"Node.js", "PostgreSQL"}, chrono::milliseconds(20)},
+    };
+    ProvisioningScheduler scheduler(16, 32, 8);
+    ProvisioningReport report;
+    VirtualMachine bareImage("Ubuntu 22.04", 4, 8);
+    auto fleet = scheduler.provision(bareImage, vector<InstallPlan>(8, webStack), report);
+    fleet.back()->displayConfiguration();
+    cout << "Provisioned " << fleet.size() << " VMs: makespan " << report.makespanSeconds * 1000
+         << "ms (sequential would be " << 8 * 140 << "ms), cloning " << report.cloneSeconds * 1000 << "ms" << endl;
+    for (const auto& [name, stage] : report.stages) {
+        cout << "  " << name << ": " << stage.count << " installs, avg "
+             << stage.totalSeconds / stage.count * 1000 << "ms, max " << stage.maxSeconds * 1000 << "ms" << endl;
+    }
+
     return 0;
 }